@@ -0,0 +1,112 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#include "Gridly.h"
+#include "GridlyColumnPlan.h"
+#include "GridlyLocalizedTextConverter.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/StringBuilder.h"
+
+#if !UE_BUILD_SHIPPING
+
+namespace GridlyBenchmark
+{
+	/** Records payload shaped like a page of the records endpoint, with non-ASCII text in every cell */
+	TArray<uint8> BuildRecordsPayload(int32 NumRecords, const TArray<FString>& ColumnIds)
+	{
+		TStringBuilder<1024> Builder;
+		Builder << TEXT("[");
+
+		for (int32 RecordIndex = 0; RecordIndex < NumRecords; RecordIndex++)
+		{
+			Builder << (RecordIndex > 0 ? TEXT(",") : TEXT("")) << TEXT("{\"id\":\"record_") << RecordIndex
+				<< TEXT("\",\"path\":\"Benchmark\",\"cells\":[");
+
+			for (int32 ColumnIndex = 0; ColumnIndex < ColumnIds.Num(); ColumnIndex++)
+			{
+				Builder << (ColumnIndex > 0 ? TEXT(",") : TEXT("")) << TEXT("{\"columnId\":\"") << ColumnIds[ColumnIndex]
+					<< TEXT("\",\"value\":\"Text ") << RecordIndex
+					<< TEXT(" f\u00FCr \u30C6\u30B9\u30C8 \\\"quoted\\\" line\\nbreak\",\"dependencyStatus\":\"upToDate\"}");
+			}
+
+			Builder << TEXT("]}");
+		}
+
+		Builder << TEXT("]");
+
+		const FTCHARToUTF8 Converted(Builder.GetData(), Builder.Len());
+
+		TArray<uint8> Payload;
+		Payload.Append(reinterpret_cast<const uint8*>(Converted.Get()), Converted.Length());
+		return Payload;
+	}
+
+	void BenchmarkRecordsDecode(const TArray<FString>& Args)
+	{
+		const int32 NumRecords = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 10000;
+		const int32 NumIterations = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 5;
+
+		// Columns of the current settings and target cultures, so the decode does the work of a real import
+
+		FGridlyColumnPlan ColumnPlan;
+		TArray<FString> ColumnIds;
+		ColumnPlan.GetMappedColumnIds(ColumnIds);
+		if (ColumnIds.Num() == 0)
+		{
+			ColumnIds = {TEXT("src_enUS"), TEXT("tg_frFR"), TEXT("tg_deDE"), TEXT("tg_jaJP")};
+		}
+
+		const TArray<uint8> Payload = BuildRecordsPayload(NumRecords, ColumnIds);
+		const FUtf8StringView Utf8Content(reinterpret_cast<const UTF8CHAR*>(Payload.GetData()), Payload.Num());
+
+		double WideSeconds = 0.0;
+		double Utf8Seconds = 0.0;
+		SIZE_T WideContentSize = 0;
+		int32 NumRecordsDecoded = 0;
+
+		for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+		{
+			// What GetContentAsString did: widen the whole body, then decode the copy
+
+			{
+				TMap<FString, FPolyglotTextData> PolyglotTextDatas;
+				const double StartTime = FPlatformTime::Seconds();
+
+				const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Payload.GetData()), Payload.Num());
+				const FString Content(Converted.Length(), Converted.Get());
+				FGridlyLocalizedTextConverter::JsonToPolyglotTextDatas(FStringView(Content), ColumnPlan, PolyglotTextDatas,
+					NumRecordsDecoded);
+
+				WideSeconds += FPlatformTime::Seconds() - StartTime;
+				WideContentSize = Content.GetAllocatedSize();
+			}
+
+			{
+				TMap<FString, FPolyglotTextData> PolyglotTextDatas;
+				const double StartTime = FPlatformTime::Seconds();
+
+				FGridlyLocalizedTextConverter::JsonToPolyglotTextDatas(Utf8Content, ColumnPlan, PolyglotTextDatas,
+					NumRecordsDecoded);
+
+				Utf8Seconds += FPlatformTime::Seconds() - StartTime;
+			}
+		}
+
+		// The conversion also holds a buffer of the same size while the string is copied out of it
+
+		UE_LOG(LogGridly, Display, TEXT("Decoded %d records of %d columns (%d bytes of UTF-8), %d iterations"),
+			NumRecordsDecoded, ColumnIds.Num(), Payload.Num(), NumIterations);
+		UE_LOG(LogGridly, Display, TEXT("  Widened to TCHAR: %.2f ms per page, %llu bytes of temporaries"),
+			WideSeconds * 1000.0 / NumIterations, static_cast<uint64>(WideContentSize * 2));
+		UE_LOG(LogGridly, Display, TEXT("  Read as UTF-8:    %.2f ms per page"),
+			Utf8Seconds * 1000.0 / NumIterations);
+	}
+
+	static FAutoConsoleCommand BenchmarkRecordsDecodeCommand(
+		TEXT("Gridly.BenchmarkRecordsDecode"),
+		TEXT("Compares decoding a synthetic page of records from UTF-8 with widening it to TCHAR first. ")
+		TEXT("Arguments: [NumRecords=10000] [NumIterations=5]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkRecordsDecode));
+}
+
+#endif
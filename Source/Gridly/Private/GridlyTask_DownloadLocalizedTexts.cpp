@@ -2,18 +2,76 @@
 
 #include "GridlyTask_DownloadLocalizedTexts.h"
 
-#include "Engine/EngineTypes.h"
-#include "Engine/World.h"
-#include "TimerManager.h"
 #include "Gridly.h"
+#include "GridlyCultureConverter.h"
 #include "GridlyGameSettings.h"
+#include "GridlyHttp.h"
 #include "GridlyLocalizedTextConverter.h"
-#include "GridlyTableRow.h"
-#include "HttpModule.h"
-#include "JsonObjectConverter.h"
-#include "GenericPlatform/GenericPlatformHttp.h"
 #include "Runtime/Online/HTTP/Public/Interfaces/IHttpResponse.h"
 
+struct FGridlyLocalizedTextsPage : public FGridlyPageData
+{
+	TArray<FPolyglotTextData> PolyglotTextDatas;
+
+	virtual void Serialize(FArchive& Ar) override
+	{
+		FGridlyPageData::Serialize(Ar);
+
+		int32 Num = PolyglotTextDatas.Num();
+		Ar << Num;
+
+		if (Ar.IsLoading())
+		{
+			PolyglotTextDatas.SetNum(Num);
+		}
+
+		for (FPolyglotTextData& PolyglotTextData : PolyglotTextDatas)
+		{
+			FGridlyLocalizedTextConverter::SerializePolyglotTextData(Ar, PolyglotTextData);
+		}
+	}
+
+	virtual void HashRecords(TMap<FString, uint32>& OutRecordHashes) const override
+	{
+		for (const FPolyglotTextData& PolyglotTextData : PolyglotTextDatas)
+		{
+			OutRecordHashes.Add(PolyglotTextData.GetNamespace() + TEXT(",") + PolyglotTextData.GetKey(),
+				FGridlyLocalizedTextConverter::HashPolyglotTextData(PolyglotTextData));
+		}
+	}
+};
+
+// Snapshots are decoded with the column and culture settings, so any change to those invalidates them
+static uint32 GetSnapshotSchemaHash(const UGridlyGameSettings* GameSettings)
+{
+	uint32 Hash = FGridlySnapshot::HashString(GameSettings->bUseCombinedNamespaceId ? TEXT("1") : TEXT("0"));
+	Hash = FGridlySnapshot::HashString(GameSettings->NamespaceColumnId, Hash);
+	Hash = FGridlySnapshot::HashString(GameSettings->SourceLanguageColumnIdPrefix, Hash);
+	Hash = FGridlySnapshot::HashString(GameSettings->TargetLanguageColumnIdPrefix, Hash);
+
+	if (GameSettings->bUseCustomCultureMapping)
+	{
+		for (const TPair<FString, FString>& Pair : GameSettings->CustomCultureMapping)
+		{
+			Hash = FGridlySnapshot::HashString(Pair.Key, Hash);
+			Hash = FGridlySnapshot::HashString(Pair.Value, Hash);
+		}
+	}
+
+	for (const FString& Culture : FGridlyCultureConverter::GetTargetCultures())
+	{
+		Hash = FGridlySnapshot::HashString(Culture, Hash);
+	}
+
+	return Hash;
+}
+
+// Texts end up in the same .po entry when they share a namespace and key, whichever record they came from
+static FString GetDuplicateKey(const FPolyglotTextData& PolyglotTextData)
+{
+	return PolyglotTextData.GetNamespace() + TEXT(",") + PolyglotTextData.GetKey();
+}
+
 UGridlyTask_DownloadLocalizedTexts::UGridlyTask_DownloadLocalizedTexts()
 {
 	if (!HasAnyFlags(RF_ClassDefaultObject))
@@ -26,10 +84,7 @@ void UGridlyTask_DownloadLocalizedTexts::Activate()
 {
 	const UGridlyGameSettings* GameSettings = GetMutableDefault<UGridlyGameSettings>();
 
-	Limit = GameSettings->ImportMaxRecordsPerRequest;
-	TotalCount = 0;
-
-	ViewIds.Reset();
+	TArray<FString> ViewIds;
 	for (int i = 0; i < GameSettings->ImportFromViewIds.Num(); i++)
 	{
 		if (!GameSettings->ImportFromViewIds[i].IsEmpty())
@@ -39,14 +94,17 @@ void UGridlyTask_DownloadLocalizedTexts::Activate()
 	}
 
 	PolyglotTextDatas.Reset();
+	NumRecordsReceived = 0;
+	RecordIndices.Reset();
+	NumDuplicateRecords = 0;
+	ColumnPlans.Reset();
 
-	RequestPage(0, 0);
-}
-
-void UGridlyTask_DownloadLocalizedTexts::RequestPage(const int ViewIdIndex, const int Offset)
-{
-	CurrentViewIdIndex = ViewIdIndex;
-	CurrentOffset = Offset;
+	TextSegments.Reset();
+	if (GameSettings->ImportMemoryBudgetMB > 0)
+	{
+		TextSegments = MakeShared<FGridlyTextSegments, ESPMode::ThreadSafe>(
+			static_cast<int64>(GameSettings->ImportMemoryBudgetMB) * 1024 * 1024);
+	}
 
 	if (ViewIds.Num() == 0)
 	{
@@ -58,126 +116,204 @@ void UGridlyTask_DownloadLocalizedTexts::RequestPage(const int ViewIdIndex, cons
 		return;
 	}
 
-	if (ViewIdIndex < ViewIds.Num())
+	for (int i = 0; i < ViewIds.Num(); i++)
 	{
-		const FString& ViewId = ViewIds[ViewIdIndex];
+		ColumnPlans.Add(MakeShared<FGridlyColumnPlan, ESPMode::ThreadSafe>());
+	}
 
-		const UGridlyGameSettings* GameSettings = GetMutableDefault<UGridlyGameSettings>();
-		const FString ApiKey = GameSettings->ImportApiKey;
+	PageFetcher = MakeShared<FGridlyPageFetcher>(ViewIds, GameSettings->ImportApiKey, GameSettings->ImportMaxRecordsPerRequest,
+		GameSettings->ImportMaxConcurrentRequests);
+	PageFetcher->OnDecodePage.BindUObject(this, &UGridlyTask_DownloadLocalizedTexts::DecodePage);
+	PageFetcher->OnCreatePage.BindLambda([]() -> TSharedRef<FGridlyPageData>
+	{
+		return MakeShared<FGridlyLocalizedTextsPage>();
+	});
+	PageFetcher->OnCommitPage.BindUObject(this, &UGridlyTask_DownloadLocalizedTexts::CommitPage);
+	PageFetcher->OnComplete.BindUObject(this, &UGridlyTask_DownloadLocalizedTexts::OnFetchComplete);
+	PageFetcher->OnFail.BindUObject(this, &UGridlyTask_DownloadLocalizedTexts::OnFetchFail);
 
-		const FString PaginationSettings =
-			FGenericPlatformHttp::UrlEncode(FString::Printf(TEXT("{\"offset\":%d,\"limit\":%d}"), Offset, Limit));
+	// Every view shares the same column settings and cultures, so the first plan decides the columns of all of them
 
-		FStringFormatNamedArguments Args;
-		Args.Add(TEXT("ViewId"), *ViewId);
-		Args.Add(TEXT("PaginationSettings"), *PaginationSettings);
-		const FString Url = FString::Format(TEXT("https://api.gridly.com/v1/views/{ViewId}/records?page={PaginationSettings}"),
-			Args);
+	TArray<FString> ColumnIds;
+	if (GameSettings->bImportMappedColumnsOnly && ColumnPlans[0]->GetMappedColumnIds(ColumnIds))
+	{
+		PageFetcher->SetColumnIds(ColumnIds);
+	}
 
-		HttpRequest = FHttpModule::Get().CreateRequest();
-		HttpRequest->SetHeader(TEXT("Accept"), TEXT("application/json"));
-		HttpRequest->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
-		HttpRequest->SetHeader(TEXT("Authorization"), FString::Printf(TEXT("ApiKey %s"), *ApiKey));
+	if (GameSettings->bUseImportSnapshots)
+	{
+		PageFetcher->EnableSnapshots(TEXT("LocalizedTexts"), GetSnapshotSchemaHash(GameSettings),
+			FTimespan::FromMinutes(GameSettings->ImportSnapshotMaxAgeMinutes));
+	}
 
-		HttpRequest->SetVerb(TEXT("GET"));
-		HttpRequest->SetURL(Url);
+	if (GameSettings->bUseImportCheckpoints)
+	{
+		PageFetcher->EnableCheckpoints(TEXT("LocalizedTexts"), GetSnapshotSchemaHash(GameSettings),
+			FTimespan::FromMinutes(GameSettings->ImportCheckpointMaxAgeMinutes));
+	}
 
-		HttpRequest->OnProcessRequestComplete().BindUObject(this, &UGridlyTask_DownloadLocalizedTexts::OnProcessRequestComplete);
+	PageFetcher->SetMaxPageRetries(GameSettings->ImportMaxPageRetries);
 
+	if (GameSettings->bBroadcastAccumulatedProgress)
+	{
 		OnProgress.Broadcast(PolyglotTextDatas, .1f, FGridlyResult::Success);
 		if (OnProgressDelegate.IsBound())
 			OnProgressDelegate.Execute(PolyglotTextDatas, .1f);
+	}
 
-		// Throttles number of requests by sleeping between each
+	PageFetcher->Start();
+}
 
-		UWorld* World = WorldContextObject != nullptr ? WorldContextObject->GetWorld() : nullptr;
-		if (World)
-		{
-			FTimerHandle TimerHandle;
-			World->GetTimerManager().SetTimer(TimerHandle, [this, ViewId, Offset]()
-			{
-				HttpRequest->ProcessRequest();
-				UE_LOG(LogGridly, Log, TEXT("Requesting view ID: %s, with offset: %d, limit: %d"), *ViewId, Offset, Limit);
-			}, 1.f, false);
-		}
-		else
-		{
-			HttpRequest->ProcessRequest();
-			UE_LOG(LogGridly, Log, TEXT("Requesting view ID: %s, with offset: %d, limit: %d"), *ViewId, Offset, Limit);
-			FPlatformProcess::Sleep(1.f);
-		}
+TSharedPtr<FGridlyPageData> UGridlyTask_DownloadLocalizedTexts::DecodePage(const FGridlyPageRequest& Page,
+	FHttpResponsePtr HttpResponsePtr)
+{
+	// Decode the records straight into texts, without going through a JSON DOM and table rows. The body is read as the UTF-8
+	// it arrived in, so only the kept values are converted
+
+	TArray<uint8> DecompressedContent;
+	FUtf8StringView Content;
+	if (!FGridlyHttp::GetContentAsUtf8(HttpResponsePtr, DecompressedContent, Content))
+	{
+		return nullptr;
 	}
-	else
+
+	UE_LOG(LogGridly, Verbose, TEXT("Decoding %d bytes of records"), Content.Len());
+
+	TMap<FString, FPolyglotTextData> PolyglotTextDataMap;
+	int32 NumRecords = 0;
+
+	// Called on a worker thread, the plans were all created before the fetch started
+
+	FGridlyColumnPlan& ColumnPlan = ColumnPlans[Page.ViewIdIndex].Get();
+	if (FGridlyLocalizedTextConverter::JsonToPolyglotTextDatas(Content, ColumnPlan, PolyglotTextDataMap, NumRecords))
 	{
-		OnSuccess.Broadcast(PolyglotTextDatas, 1.f, FGridlyResult::Success);
-		if (OnSuccessDelegate.IsBound())
-			OnSuccessDelegate.Execute(PolyglotTextDatas);
+		const TSharedPtr<FGridlyLocalizedTextsPage> PageData = MakeShared<FGridlyLocalizedTextsPage>();
+		PolyglotTextDataMap.GenerateValueArray(PageData->PolyglotTextDatas);
+		PageData->NumRecords = NumRecords;
+		return PageData;
 	}
+
+	return nullptr;
 }
 
-void UGridlyTask_DownloadLocalizedTexts::OnProcessRequestComplete(FHttpRequestPtr HttpRequestPtr,
-	FHttpResponsePtr HttpResponsePtr, bool bSuccess)
+void UGridlyTask_DownloadLocalizedTexts::CommitPage(const TSharedRef<FGridlyPageData>& PageData)
 {
-	if (bSuccess && HttpResponsePtr->GetResponseCode() == EHttpResponseCodes::Ok)
-	{
-		// Header
+	const FGridlyLocalizedTextsPage& LocalizedTextsPage = static_cast<const FGridlyLocalizedTextsPage&>(PageData.Get());
+	const TArray<FPolyglotTextData>& PagePolyglotTextDatas = LocalizedTextsPage.PolyglotTextDatas;
 
-		TArray<FString> Headers = HttpResponsePtr->GetAllHeaders();
-		for (int i = 0; i < Headers.Num(); i++)
-		{
-			UE_LOG(LogGridly, Verbose, TEXT("%s"), *Headers[i]);
-		}
+	const bool bLastWins = GetDefault<UGridlyGameSettings>()->ImportDuplicatePolicy == EGridlyDuplicatePolicy::LastWins;
 
-		// Convert from JSON to texts
+	// The records of the page that were kept, only gathered once the page turns out to have duplicates
 
-		const FString Content = HttpResponsePtr->GetContentAsString();
-		UE_LOG(LogGridly, Verbose, TEXT("%s"), *Content);
+	TArray<FPolyglotTextData> KeptPolyglotTextDatas;
+	bool bHasDuplicates = false;
 
-		TMap<FString, FPolyglotTextData> PolyglotTextDataMap;
-		TArray<FGridlyTableRow> TableRows;
+	for (int32 i = 0; i < PagePolyglotTextDatas.Num(); i++)
+	{
+		const FPolyglotTextData& PolyglotTextData = PagePolyglotTextDatas[i];
+		FString DuplicateKey = GetDuplicateKey(PolyglotTextData);
+		const uint32 KeyHash = GetTypeHash(DuplicateKey);
 
-		if (FJsonObjectConverter::JsonArrayStringToUStruct(Content, &TableRows, 0, 0)
-		    && FGridlyLocalizedTextConverter::TableRowsToPolyglotTextDatas(TableRows, PolyglotTextDataMap))
+		if (const int32* RecordIndex = RecordIndices.FindByHash(KeyHash, DuplicateKey))
 		{
-			TArray<FPolyglotTextData> CurrentPolyglotTextDatas;
-			PolyglotTextDataMap.GenerateValueArray(CurrentPolyglotTextDatas);
-			PolyglotTextDatas.Append(CurrentPolyglotTextDatas);
-
-			const int ViewIdTotalCount = FCString::Atoi(*HttpResponsePtr->GetHeader("X-Total-Count"));
-			TotalCount += CurrentOffset == 0 ? ViewIdTotalCount : 0;
-			const float EstimatedProgressViewIds =
-				static_cast<float>(CurrentViewIdIndex) / static_cast<float>(FMath::Max(1, ViewIds.Num()));
-			const float EstimatedProgressPagination = static_cast<float>(PolyglotTextDatas.Num()) / static_cast<float>(TotalCount);
-			const float EstimatedProgress = (EstimatedProgressViewIds + EstimatedProgressPagination) / 2.f;
-			
-			OnProgress.Broadcast(PolyglotTextDatas, EstimatedProgress, FGridlyResult::Success);
-			if (OnProgressDelegate.IsBound())
-				OnProgressDelegate.Execute(PolyglotTextDatas, EstimatedProgress);
-
-			if ((CurrentOffset + Limit) < TotalCount)
+			if (!bHasDuplicates)
 			{
-				RequestPage(CurrentViewIdIndex, CurrentOffset + Limit);
+				KeptPolyglotTextDatas.Append(PagePolyglotTextDatas.GetData(), i);
+				bHasDuplicates = true;
 			}
-			else
+
+			NumDuplicateRecords++;
+			UE_LOG(LogGridly, Verbose, TEXT("Duplicate record: %s"), *DuplicateKey);
+
+			if (bLastWins && TextSegments)
 			{
-				RequestPage(CurrentViewIdIndex + 1, 0);
+				// The segments only visit the last text added with a namespace and key
+				TextSegments->Add(PolyglotTextData);
+				KeptPolyglotTextDatas.Add(PolyglotTextData);
 			}
+			else if (bLastWins)
+			{
+				PolyglotTextDatas[*RecordIndex] = PolyglotTextData;
+				KeptPolyglotTextDatas.Add(PolyglotTextData);
+			}
+			continue;
+		}
+
+		int32 NewRecordIndex = INDEX_NONE;
+		if (TextSegments)
+		{
+			TextSegments->Add(PolyglotTextData);
 		}
 		else
 		{
-			const FGridlyResult FailResult = FGridlyResult{"Failed to parse downloaded content"};
-			OnFail.Broadcast(PolyglotTextDatas, 1.f, FailResult);
-			if (OnFailDelegate.IsBound())
-				OnFailDelegate.Execute(PolyglotTextDatas, FailResult);
+			NewRecordIndex = PolyglotTextDatas.Add(PolyglotTextData);
+		}
+
+		RecordIndices.AddByHash(KeyHash, MoveTemp(DuplicateKey), NewRecordIndex);
+
+		if (bHasDuplicates)
+		{
+			KeptPolyglotTextDatas.Add(PolyglotTextData);
 		}
 	}
-	else
+
+	BroadcastPage(bHasDuplicates ? KeptPolyglotTextDatas : PagePolyglotTextDatas, LocalizedTextsPage.NumRecords);
+}
+
+void UGridlyTask_DownloadLocalizedTexts::BroadcastPage(const TArray<FPolyglotTextData>& PagePolyglotTextDatas, int32 NumPageRecords)
+{
+	NumRecordsReceived += NumPageRecords;
+
+	const float EstimatedProgressViewIds =
+		static_cast<float>(PageFetcher->GetCurrentViewIdIndex()) / static_cast<float>(FMath::Max(1, PageFetcher->GetNumViews()));
+	const float EstimatedProgressPagination =
+		static_cast<float>(NumRecordsReceived) / static_cast<float>(FMath::Max(1, PageFetcher->GetTotalCount()));
+	const float EstimatedProgress = (EstimatedProgressViewIds + EstimatedProgressPagination) / 2.f;
+
+	// Blueprint listeners receive a copy of the array, so only the page is passed unless everything so far is asked for
+
+	OnPage.Broadcast(PagePolyglotTextDatas, EstimatedProgress, FGridlyResult::Success);
+	if (OnPageDelegate.IsBound())
+		OnPageDelegate.Execute(PagePolyglotTextDatas, NumRecordsReceived, PageFetcher->GetTotalCount());
+
+	if (GetDefault<UGridlyGameSettings>()->bBroadcastAccumulatedProgress)
+	{
+		OnProgress.Broadcast(PolyglotTextDatas, EstimatedProgress, FGridlyResult::Success);
+		if (OnProgressDelegate.IsBound())
+			OnProgressDelegate.Execute(PolyglotTextDatas, EstimatedProgress);
+	}
+}
+
+void UGridlyTask_DownloadLocalizedTexts::OnFetchComplete()
+{
+	if (NumDuplicateRecords > 0)
+	{
+		UE_LOG(LogGridly, Log, TEXT("Resolved %d duplicate records, keeping the %s one of each"), NumDuplicateRecords,
+			GetDefault<UGridlyGameSettings>()->ImportDuplicatePolicy == EGridlyDuplicatePolicy::LastWins ? TEXT("last") : TEXT("first"));
+	}
+
+	if (TextSegments && !TextSegments->Finish())
 	{
-		const FGridlyResult FailResult = FGridlyResult{"Failed to connect to Gridly"};
-		OnFail.Broadcast(PolyglotTextDatas, 1.f, FailResult);
-		if (OnFailDelegate.IsBound())
-			OnFailDelegate.Execute(PolyglotTextDatas, FailResult);
+		OnFetchFail(TEXT("Unable to spill downloaded texts to disk"));
+		return;
 	}
+
+	OnSuccess.Broadcast(PolyglotTextDatas, 1.f, FGridlyResult::Success);
+	if (OnSuccessDelegate.IsBound())
+		OnSuccessDelegate.Execute(PolyglotTextDatas);
+
+	// Listeners keep the segments alive as long as they need them, the files are deleted once the last one lets go
+	TextSegments.Reset();
+}
+
+void UGridlyTask_DownloadLocalizedTexts::OnFetchFail(const FString& Message)
+{
+	const FGridlyResult FailResult = FGridlyResult{Message};
+	OnFail.Broadcast(PolyglotTextDatas, 1.f, FailResult);
+	if (OnFailDelegate.IsBound())
+		OnFailDelegate.Execute(PolyglotTextDatas, FailResult);
+
+	TextSegments.Reset();
 }
 
 UGridlyTask_DownloadLocalizedTexts* UGridlyTask_DownloadLocalizedTexts::DownloadLocalizedTexts(const UObject* WorldContextObject)
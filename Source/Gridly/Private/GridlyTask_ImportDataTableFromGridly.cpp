@@ -2,17 +2,126 @@
 
 #include "GridlyTask_ImportDataTableFromGridly.h"
 
-#include "Engine/EngineTypes.h"
-#include "Engine/World.h"
-#include "TimerManager.h"
 #include "GridlyDataTableImporterJSON.h"
 #include "Gridly.h"
 #include "GridlyGameSettings.h"
+#include "GridlyHttp.h"
+#include "GridlyJsonRecordsReader.h"
 #include "GridlyTableRow.h"
-#include "HttpModule.h"
-#include "JsonObjectConverter.h"
-#include "GenericPlatform/GenericPlatformHttp.h"
 #include "Runtime/Online/HTTP/Public/Interfaces/IHttpResponse.h"
+#include "Serialization/JsonSerializer.h"
+
+struct FGridlyTableRowsPage : public FGridlyPageData
+{
+	TArray<FGridlyTableRow> TableRows;
+
+	virtual void Serialize(FArchive& Ar) override
+	{
+		FGridlyPageData::Serialize(Ar);
+		Ar << TableRows;
+	}
+
+	virtual void HashRecords(TMap<FString, uint32>& OutRecordHashes) const override
+	{
+		for (const FGridlyTableRow& TableRow : TableRows)
+		{
+			uint32 Hash = FGridlySnapshot::HashString(TableRow.Path);
+			for (const FGridlyTableCell& Cell : TableRow.Cells)
+			{
+				Hash = FGridlySnapshot::HashString(Cell.ColumnId, Hash);
+				Hash = FGridlySnapshot::HashString(Cell.Value, Hash);
+			}
+
+			OutRecordHashes.Add(TableRow.Id, Hash);
+		}
+	}
+};
+
+namespace GridlyTask_ImportDataTableFromGridly
+{
+/** Decodes a page of records into table rows, leaving out the cells of columns not in ColumnIds unless it is empty */
+template <typename CharType>
+bool JsonToTableRows(const CharType* Json, int32 JsonLen, const TSet<FString>& ColumnIds,
+	TArray<FGridlyTableRow>& OutTableRows)
+{
+	FString FieldName;
+	FString CellFieldName;
+
+	TGridlyJsonRecordsReader<CharType> Reader(Json, JsonLen);
+	if (!Reader.ReadArrayStart())
+	{
+		return false;
+	}
+
+	while (Reader.NextElement())
+	{
+		if (!Reader.ReadObjectStart())
+		{
+			return false;
+		}
+
+		FGridlyTableRow& TableRow = OutTableRows.AddDefaulted_GetRef();
+
+		while (Reader.NextField(FieldName))
+		{
+			if (FieldName == TEXT("id"))
+			{
+				Reader.ReadString(TableRow.Id);
+			}
+			else if (FieldName == TEXT("path"))
+			{
+				Reader.ReadString(TableRow.Path);
+			}
+			else if (FieldName == TEXT("cells") && Reader.ReadArrayStart())
+			{
+				while (Reader.NextElement() && Reader.ReadObjectStart())
+				{
+					FGridlyTableCell Cell;
+					bool bKeep = true;
+
+					while (Reader.NextField(CellFieldName))
+					{
+						if (CellFieldName == TEXT("columnId"))
+						{
+							Reader.ReadString(Cell.ColumnId);
+							bKeep = ColumnIds.Num() == 0 || ColumnIds.Contains(Cell.ColumnId);
+						}
+						else if (bKeep && CellFieldName == TEXT("value"))
+						{
+							Reader.ReadString(Cell.Value);
+						}
+						else if (bKeep && CellFieldName == TEXT("dependencyStatus"))
+						{
+							Reader.ReadString(Cell.DependencyStatus);
+						}
+						else
+						{
+							Reader.SkipValue();
+						}
+					}
+
+					if (bKeep)
+					{
+						TableRow.Cells.Add(MoveTemp(Cell));
+					}
+				}
+			}
+			else
+			{
+				Reader.SkipValue();
+			}
+		}
+	}
+
+	return !Reader.HasError();
+}
+}
+
+// Rows are named after their record ID, so rows sharing one would be duplicate rows of the data table
+static FString GetDuplicateKey(const FGridlyTableRow& TableRow)
+{
+	return TableRow.Id;
+}
 
 UGridlyTask_ImportDataTableFromGridly::UGridlyTask_ImportDataTableFromGridly()
 {
@@ -26,24 +135,17 @@ void UGridlyTask_ImportDataTableFromGridly::Activate()
 {
 	const UGridlyGameSettings* GameSettings = GetMutableDefault<UGridlyGameSettings>();
 
-	Limit = GameSettings->ImportMaxRecordsPerRequest;
-	TotalCount = 0;
-
-	ViewIds.Reset();
+	TArray<FString> ViewIds;
 	if (GridlyDataTable && !GridlyDataTable->ViewId.IsEmpty())
 	{
 		ViewIds.Add(GridlyDataTable->ViewId);
 	}
 
 	GridlyTableRows.Reset();
-
-	RequestPage(0, 0);
-}
-
-void UGridlyTask_ImportDataTableFromGridly::RequestPage(const int ViewIdIndex, const int Offset)
-{
-	CurrentViewIdIndex = ViewIdIndex;
-	CurrentOffset = Offset;
+	NumRecordsReceived = 0;
+	RecordIndices.Reset();
+	NumDuplicateRecords = 0;
+	ImportColumnIds.Reset();
 
 	if (ViewIds.Num() == 0)
 	{
@@ -55,164 +157,210 @@ void UGridlyTask_ImportDataTableFromGridly::RequestPage(const int ViewIdIndex, c
 		return;
 	}
 
-	if (ViewIdIndex < ViewIds.Num())
+	PageFetcher = MakeShared<FGridlyPageFetcher>(ViewIds, GameSettings->ImportApiKey, GameSettings->ImportMaxRecordsPerRequest,
+		GameSettings->ImportMaxConcurrentRequests);
+	PageFetcher->OnDecodePage.BindUObject(this, &UGridlyTask_ImportDataTableFromGridly::DecodePage);
+	PageFetcher->OnCreatePage.BindLambda([]() -> TSharedRef<FGridlyPageData>
 	{
-		const FString& ViewId = ViewIds[ViewIdIndex];
+		return MakeShared<FGridlyTableRowsPage>();
+	});
+	PageFetcher->OnCommitPage.BindUObject(this, &UGridlyTask_ImportDataTableFromGridly::CommitPage);
+	PageFetcher->OnComplete.BindUObject(this, &UGridlyTask_ImportDataTableFromGridly::OnFetchComplete);
+	PageFetcher->OnFail.BindUObject(this, &UGridlyTask_ImportDataTableFromGridly::OnFetchFail);
 
-		const UGridlyGameSettings* GameSettings = GetMutableDefault<UGridlyGameSettings>();
-		const FString ApiKey = GameSettings->ImportApiKey;
+	// Only the columns that have a property to be imported into are requested
 
-		const FString PaginationSettings = FGenericPlatformHttp::UrlEncode(FString::Printf(TEXT("{\"offset\":%d,\"limit\":%d}"),
-			Offset,
-			Limit));
+	TArray<FString> ColumnIds;
+	if (GameSettings->bImportMappedColumnsOnly && GridlyDataTable->RowStruct)
+	{
+		GridlyDataTableJSONUtils::GetImportColumnIds(*GridlyDataTable, ColumnIds);
+	}
 
-		FStringFormatNamedArguments Args;
-		Args.Add(TEXT("ViewId"), *ViewId);
-		Args.Add(TEXT("PaginationSettings"), *PaginationSettings);
-		const FString Url = FString::Format(TEXT("https://api.gridly.com/v1/views/{ViewId}/records?page={PaginationSettings}"),
-			Args);
+	if (ColumnIds.Num() > 0)
+	{
+		ImportColumnIds.Append(ColumnIds);
+		PageFetcher->SetColumnIds(ColumnIds);
+	}
 
-		HttpRequest = FHttpModule::Get().CreateRequest();
-		HttpRequest->SetHeader(TEXT("Accept"), TEXT("application/json"));
-		HttpRequest->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
-		HttpRequest->SetHeader(TEXT("Authorization"), FString::Printf(TEXT("ApiKey %s"), *ApiKey));
+	if (GameSettings->bUseImportSnapshots)
+	{
+		PageFetcher->EnableSnapshots(TEXT("DataTable"), 0, FTimespan::FromMinutes(GameSettings->ImportSnapshotMaxAgeMinutes));
+	}
 
-		HttpRequest->SetVerb(TEXT("GET"));
-		HttpRequest->SetURL(Url);
+	if (GameSettings->bUseImportCheckpoints)
+	{
+		PageFetcher->EnableCheckpoints(TEXT("DataTable"), 0, FTimespan::FromMinutes(GameSettings->ImportCheckpointMaxAgeMinutes));
+	}
 
-		HttpRequest->OnProcessRequestComplete().BindUObject(this, &UGridlyTask_ImportDataTableFromGridly::OnProcessRequestComplete);
+	PageFetcher->SetMaxPageRetries(GameSettings->ImportMaxPageRetries);
 
+	if (GameSettings->bBroadcastAccumulatedProgress)
+	{
 		OnProgress.Broadcast(GridlyTableRows, .1f, FGridlyResult::Success);
 		if (OnProgressDelegate.IsBound())
 			OnProgressDelegate.Execute(GridlyTableRows, .1f);
+	}
 
-		// Throttles number of requests by sleeping between each
+	PageFetcher->Start();
+}
 
-		UWorld* World = WorldContextObject != nullptr ? WorldContextObject->GetWorld() : nullptr;
-		if (World)
-		{
-			FTimerHandle TimerHandle;
-			World->GetTimerManager().SetTimer(TimerHandle, [this, ViewId, Offset]()
-			{
-				HttpRequest->ProcessRequest();
-				UE_LOG(LogGridly, Log, TEXT("Requesting view ID: %s, with offset: %d, limit: %d"), *ViewId, Offset, Limit);
-			}, 1.f, false);
-		}
-		else
-		{
-			HttpRequest->ProcessRequest();
-			UE_LOG(LogGridly, Log, TEXT("Requesting view ID: %s, with offset: %d, limit: %d"), *ViewId, Offset, Limit);
-			FPlatformProcess::Sleep(1.f);
-		}
+TSharedPtr<FGridlyPageData> UGridlyTask_ImportDataTableFromGridly::DecodePage(const FGridlyPageRequest& Page,
+	FHttpResponsePtr HttpResponsePtr)
+{
+	// Convert from JSON to table rows, without going through a JSON DOM or widening the UTF-8 body first
+
+	TArray<uint8> DecompressedContent;
+	FUtf8StringView Content;
+	if (!FGridlyHttp::GetContentAsUtf8(HttpResponsePtr, DecompressedContent, Content))
+	{
+		return nullptr;
 	}
-	else
+
+	UE_LOG(LogGridly, Verbose, TEXT("Decoding %d bytes of records"), Content.Len());
+
+	const TSharedPtr<FGridlyTableRowsPage> PageData = MakeShared<FGridlyTableRowsPage>();
+	if (GridlyTask_ImportDataTableFromGridly::JsonToTableRows(Content.GetData(), Content.Len(), ImportColumnIds,
+		PageData->TableRows))
 	{
-		TArray<TSharedPtr<FJsonValue>> JsonValues;
+		PageData->NumRecords = PageData->TableRows.Num();
+		return PageData;
+	}
 
-		for (int i = 0; i < GridlyTableRows.Num(); i++)
-		{
-			const TSharedPtr<FJsonObject> JsonObject = MakeShareable(new FJsonObject);
-			JsonObject->SetStringField("name", GridlyTableRows[i].Id);
+	return nullptr;
+}
 
-			for (int j = 0; j < GridlyTableRows[i].Cells.Num(); j++)
-			{
-				JsonObject->SetStringField("_path", GridlyTableRows[i].Path);
-				JsonObject->SetStringField(GridlyTableRows[i].Cells[j].ColumnId, GridlyTableRows[i].Cells[j].Value);
-			}
+void UGridlyTask_ImportDataTableFromGridly::CommitPage(const TSharedRef<FGridlyPageData>& PageData)
+{
+	const FGridlyTableRowsPage& TableRowsPage = static_cast<const FGridlyTableRowsPage&>(PageData.Get());
+	const TArray<FGridlyTableRow>& PageGridlyTableRows = TableRowsPage.TableRows;
 
-			JsonValues.Add(MakeShareable(new FJsonValueObject(JsonObject)));
-		}
+	const bool bLastWins = GetDefault<UGridlyGameSettings>()->ImportDuplicatePolicy == EGridlyDuplicatePolicy::LastWins;
 
-		GridlyDataTable->EmptyTable();
+	// The records of the page that were kept, only gathered once the page turns out to have duplicates
 
-		FString JsonString;
-		const TSharedRef<TJsonWriter<>> JsonWriter = TJsonStringWriter<>::Create(&JsonString);
-		FJsonSerializer::Serialize(JsonValues, JsonWriter);
+	TArray<FGridlyTableRow> KeptGridlyTableRows;
+	bool bHasDuplicates = false;
 
-		TArray<FString> OutProblems;
-		if (FGridlyDataTableImporterJSON(*GridlyDataTable, JsonString, OutProblems).ReadTable())
-		{
-			UE_LOG(LogGridly, Log, TEXT("Imported data table from Gridly: %s"), *GridlyDataTable->GetName());
-			OnSuccess.Broadcast(GridlyTableRows, 1.f, FGridlyResult::Success);
-			if (OnSuccessDelegate.IsBound())
-				OnSuccessDelegate.Execute(GridlyTableRows);
-		}
-		else
+	for (int32 i = 0; i < PageGridlyTableRows.Num(); i++)
+	{
+		const FGridlyTableRow& TableRow = PageGridlyTableRows[i];
+		FString DuplicateKey = GetDuplicateKey(TableRow);
+		const uint32 KeyHash = GetTypeHash(DuplicateKey);
+
+		if (const int32* RecordIndex = RecordIndices.FindByHash(KeyHash, DuplicateKey))
 		{
-			for (int i = 0; i < OutProblems.Num(); i++)
+			if (!bHasDuplicates)
 			{
-				UE_LOG(LogGridly, Error, TEXT("%s"), *OutProblems[i]);
+				KeptGridlyTableRows.Append(PageGridlyTableRows.GetData(), i);
+				bHasDuplicates = true;
 			}
 
-			const FGridlyResult FailResult = FGridlyResult{"Failed to parse downloaded content"};
-			OnFail.Broadcast(GridlyTableRows, 1.f, FailResult);
-			if (OnFailDelegate.IsBound())
-				OnFailDelegate.Execute(GridlyTableRows, FailResult);
+			NumDuplicateRecords++;
+			UE_LOG(LogGridly, Verbose, TEXT("Duplicate record: %s"), *DuplicateKey);
+
+			if (bLastWins)
+			{
+				GridlyTableRows[*RecordIndex] = TableRow;
+				KeptGridlyTableRows.Add(TableRow);
+			}
+			continue;
+		}
+
+		RecordIndices.AddByHash(KeyHash, MoveTemp(DuplicateKey), GridlyTableRows.Add(TableRow));
+
+		if (bHasDuplicates)
+		{
+			KeptGridlyTableRows.Add(TableRow);
 		}
 	}
+
+	BroadcastPage(bHasDuplicates ? KeptGridlyTableRows : PageGridlyTableRows, TableRowsPage.NumRecords);
 }
 
-void UGridlyTask_ImportDataTableFromGridly::OnProcessRequestComplete(FHttpRequestPtr HttpRequestPtr,
-	FHttpResponsePtr HttpResponsePtr, bool bSuccess)
+void UGridlyTask_ImportDataTableFromGridly::BroadcastPage(const TArray<FGridlyTableRow>& PageGridlyTableRows, int32 NumPageRecords)
 {
-	if (bSuccess && HttpResponsePtr->GetResponseCode() == EHttpResponseCodes::Ok)
-	{
-		// Header
+	NumRecordsReceived += NumPageRecords;
 
-		TArray<FString> Headers = HttpResponsePtr->GetAllHeaders();
-		for (int i = 0; i < Headers.Num(); i++)
-		{
-			UE_LOG(LogGridly, Verbose, TEXT("%s"), *Headers[i]);
-		}
+	const float EstimatedProgressViewIds =
+		static_cast<float>(PageFetcher->GetCurrentViewIdIndex()) / static_cast<float>(FMath::Max(1, PageFetcher->GetNumViews()));
+	const float EstimatedProgressPagination =
+		static_cast<float>(NumRecordsReceived) / static_cast<float>(FMath::Max(1, PageFetcher->GetTotalCount()));
+	const float EstimatedProgress = (EstimatedProgressViewIds + EstimatedProgressPagination) / 2.f;
 
-		// Convert from JSON to texts
+	// Blueprint listeners receive a copy of the array, so only the page is passed unless every row so far is asked for
 
-		const FString Content = HttpResponsePtr->GetContentAsString();
-		UE_LOG(LogGridly, Verbose, TEXT("%s"), *Content);
+	OnPage.Broadcast(PageGridlyTableRows, EstimatedProgress, FGridlyResult::Success);
+	if (OnPageDelegate.IsBound())
+		OnPageDelegate.Execute(PageGridlyTableRows, NumRecordsReceived, PageFetcher->GetTotalCount());
 
-		TArray<FGridlyTableRow> TableRows;
+	if (GetDefault<UGridlyGameSettings>()->bBroadcastAccumulatedProgress)
+	{
+		OnProgress.Broadcast(GridlyTableRows, EstimatedProgress, FGridlyResult::Success);
+		if (OnProgressDelegate.IsBound())
+			OnProgressDelegate.Execute(GridlyTableRows, EstimatedProgress);
+	}
+}
 
-		if (FJsonObjectConverter::JsonArrayStringToUStruct(Content, &TableRows, 0, 0))
-		{
-			GridlyTableRows.Append(TableRows);
+void UGridlyTask_ImportDataTableFromGridly::OnFetchComplete()
+{
+	if (NumDuplicateRecords > 0)
+	{
+		UE_LOG(LogGridly, Log, TEXT("Resolved %d duplicate records, keeping the %s one of each"), NumDuplicateRecords,
+			GetDefault<UGridlyGameSettings>()->ImportDuplicatePolicy == EGridlyDuplicatePolicy::LastWins ? TEXT("last") : TEXT("first"));
+	}
 
-			const int ViewIdTotalCount = FCString::Atoi(*HttpResponsePtr->GetHeader("X-Total-Count"));
-			TotalCount += CurrentOffset == 0 ? ViewIdTotalCount : 0;
-			const float EstimatedProgressViewIds =
-				static_cast<float>(CurrentViewIdIndex) / static_cast<float>(FMath::Max(1, ViewIds.Num()));
-			const float EstimatedProgressPagination = static_cast<float>(GridlyTableRows.Num()) / static_cast<float>(TotalCount);
-			const float EstimatedProgress = (EstimatedProgressViewIds + EstimatedProgressPagination) / 2.f;
+	TArray<TSharedPtr<FJsonValue>> JsonValues;
 
-			OnProgress.Broadcast(GridlyTableRows, EstimatedProgress, FGridlyResult::Success);
-			if (OnProgressDelegate.IsBound())
-				OnProgressDelegate.Execute(GridlyTableRows, EstimatedProgress);
+	for (int i = 0; i < GridlyTableRows.Num(); i++)
+	{
+		const TSharedPtr<FJsonObject> JsonObject = MakeShareable(new FJsonObject);
+		JsonObject->SetStringField("name", GridlyTableRows[i].Id);
 
-			if ((CurrentOffset + Limit) < TotalCount)
-			{
-				RequestPage(CurrentViewIdIndex, CurrentOffset + Limit);
-			}
-			else
-			{
-				RequestPage(CurrentViewIdIndex + 1, 0);
-			}
-		}
-		else
+		for (int j = 0; j < GridlyTableRows[i].Cells.Num(); j++)
 		{
-			const FGridlyResult FailResult = FGridlyResult{"Failed to parse downloaded content"};
-			OnFail.Broadcast(GridlyTableRows, 1.f, FailResult);
-			if (OnFailDelegate.IsBound())
-				OnFailDelegate.Execute(GridlyTableRows, FailResult);
+			JsonObject->SetStringField("_path", GridlyTableRows[i].Path);
+			JsonObject->SetStringField(GridlyTableRows[i].Cells[j].ColumnId, GridlyTableRows[i].Cells[j].Value);
 		}
+
+		JsonValues.Add(MakeShareable(new FJsonValueObject(JsonObject)));
+	}
+
+	GridlyDataTable->EmptyTable();
+
+	FString JsonString;
+	const TSharedRef<TJsonWriter<>> JsonWriter = TJsonStringWriter<>::Create(&JsonString);
+	FJsonSerializer::Serialize(JsonValues, JsonWriter);
+
+	TArray<FString> OutProblems;
+	if (FGridlyDataTableImporterJSON(*GridlyDataTable, JsonString, OutProblems).ReadTable())
+	{
+		UE_LOG(LogGridly, Log, TEXT("Imported data table from Gridly: %s"), *GridlyDataTable->GetName());
+		OnSuccess.Broadcast(GridlyTableRows, 1.f, FGridlyResult::Success);
+		if (OnSuccessDelegate.IsBound())
+			OnSuccessDelegate.Execute(GridlyTableRows);
 	}
 	else
 	{
-		const FGridlyResult FailResult = FGridlyResult{"Failed to connect to Gridly"};
+		for (int i = 0; i < OutProblems.Num(); i++)
+		{
+			UE_LOG(LogGridly, Error, TEXT("%s"), *OutProblems[i]);
+		}
+
+		const FGridlyResult FailResult = FGridlyResult{"Failed to parse downloaded content"};
 		OnFail.Broadcast(GridlyTableRows, 1.f, FailResult);
 		if (OnFailDelegate.IsBound())
 			OnFailDelegate.Execute(GridlyTableRows, FailResult);
 	}
 }
 
+void UGridlyTask_ImportDataTableFromGridly::OnFetchFail(const FString& Message)
+{
+	const FGridlyResult FailResult = FGridlyResult{Message};
+	OnFail.Broadcast(GridlyTableRows, 1.f, FailResult);
+	if (OnFailDelegate.IsBound())
+		OnFailDelegate.Execute(GridlyTableRows, FailResult);
+}
+
 UGridlyTask_ImportDataTableFromGridly* UGridlyTask_ImportDataTableFromGridly::ImportDataTableFromGridly(
 	const UObject* WorldContextObject, UGridlyDataTable* GridlyDataTable)
 {
@@ -0,0 +1,142 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#include "GridlyCheckpoint.h"
+
+#include "Gridly.h"
+#include "GridlyPageFetcher.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+static constexpr uint32 GridlyCheckpointMagic = 0x4743504B;
+static constexpr int32 GridlyCheckpointVersion = 1;
+
+FGridlyCheckpoint::FGridlyCheckpoint(const FString& Kind, const FString& ViewId, uint32 InSchemaHash, int32 InLimit) :
+	Directory(FPaths::ProjectSavedDir() / TEXT("Gridly") / TEXT("Checkpoints") / Kind / FPaths::MakeValidFileName(ViewId)),
+	SchemaHash(InSchemaHash),
+	Limit(InLimit),
+	bBegun(false)
+{
+}
+
+bool FGridlyCheckpoint::Resume(const FTimespan& MaxAge, TFunctionRef<TSharedRef<FGridlyPageData>()> CreatePage,
+	int32& OutTotalCount, TArray<TSharedRef<FGridlyPageData>>& OutPages)
+{
+	OutTotalCount = INDEX_NONE;
+	OutPages.Reset();
+
+	const TUniquePtr<FArchive> SessionArchive(
+		IFileManager::Get().CreateFileReader(*(Directory / TEXT("Session.bin")), FILEREAD_Silent));
+	if (!SessionArchive)
+	{
+		return false;
+	}
+
+	uint32 Magic = 0;
+	int32 Version = 0;
+	uint32 SessionSchemaHash = 0;
+	int32 SessionLimit = 0;
+	int32 TotalCount = 0;
+	FDateTime StartTime;
+	*SessionArchive << Magic << Version << SessionSchemaHash << SessionLimit << TotalCount << StartTime;
+
+	if (SessionArchive->IsError() || Magic != GridlyCheckpointMagic || Version != GridlyCheckpointVersion
+	    || SessionSchemaHash != SchemaHash || SessionLimit != Limit || FDateTime::UtcNow() - StartTime > MaxAge)
+	{
+		UE_LOG(LogGridly, Log, TEXT("Ignoring outdated checkpoint: %s"), *Directory);
+		Delete();
+		return false;
+	}
+
+	// Pages that cannot be read are requested again
+
+	TArray<FString> PageFileNames;
+	IFileManager::Get().FindFiles(PageFileNames, *(Directory / TEXT("*.page")), true, false);
+
+	for (const FString& PageFileName : PageFileNames)
+	{
+		const FString PagePath = Directory / PageFileName;
+		const TUniquePtr<FArchive> PageArchive(IFileManager::Get().CreateFileReader(*PagePath, FILEREAD_Silent));
+		if (!PageArchive)
+		{
+			continue;
+		}
+
+		const TSharedRef<FGridlyPageData> PageData = CreatePage();
+		*PageArchive << PageData->Page.Offset << PageData->ETag << PageData->LastModified;
+		PageData->Serialize(*PageArchive);
+
+		if (PageArchive->IsError() || PageData->Page.Offset < 0 || PageData->Page.Offset % Limit != 0
+		    || PagePath != GetPagePath(PageData->Page.Offset))
+		{
+			UE_LOG(LogGridly, Warning, TEXT("Ignoring damaged checkpoint page: %s"), *PagePath);
+			continue;
+		}
+
+		PageData->Page.Limit = Limit;
+		OutPages.Add(PageData);
+	}
+
+	OutTotalCount = TotalCount;
+	bBegun = true;
+	return true;
+}
+
+void FGridlyCheckpoint::Begin(int32 TotalCount)
+{
+	Delete();
+
+	const TUniquePtr<FArchive> SessionArchive(
+		IFileManager::Get().CreateFileWriter(*(Directory / TEXT("Session.bin")), FILEWRITE_Silent));
+	if (!SessionArchive)
+	{
+		UE_LOG(LogGridly, Warning, TEXT("Unable to write checkpoint: %s"), *Directory);
+		return;
+	}
+
+	uint32 Magic = GridlyCheckpointMagic;
+	int32 Version = GridlyCheckpointVersion;
+	FDateTime StartTime = FDateTime::UtcNow();
+	*SessionArchive << Magic << Version << SchemaHash << Limit << TotalCount << StartTime;
+
+	bBegun = SessionArchive->Close();
+}
+
+void FGridlyCheckpoint::WritePage(FGridlyPageData& PageData)
+{
+	if (!bBegun)
+	{
+		return;
+	}
+
+	const FString PagePath = GetPagePath(PageData.Page.Offset);
+	const FString TempPath = PagePath + TEXT(".tmp");
+
+	bool bSuccess = false;
+	{
+		const TUniquePtr<FArchive> PageArchive(IFileManager::Get().CreateFileWriter(*TempPath, FILEWRITE_Silent));
+		if (PageArchive)
+		{
+			int32 Offset = PageData.Page.Offset;
+			*PageArchive << Offset << PageData.ETag << PageData.LastModified;
+			PageData.Serialize(*PageArchive);
+			bSuccess = PageArchive->Close();
+		}
+	}
+
+	if (!bSuccess || !IFileManager::Get().Move(*PagePath, *TempPath, true, true))
+	{
+		UE_LOG(LogGridly, Warning, TEXT("Unable to write checkpoint page: %s"), *PagePath);
+		IFileManager::Get().Delete(*TempPath, false, false, true);
+	}
+}
+
+void FGridlyCheckpoint::Delete()
+{
+	bBegun = false;
+	IFileManager::Get().DeleteDirectory(*Directory, false, true);
+}
+
+FString FGridlyCheckpoint::GetPagePath(int32 Offset) const
+{
+	return Directory / FString::Printf(TEXT("%d.page"), Offset);
+}
@@ -0,0 +1,43 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FGridlyPageData;
+
+/**
+ * Decoded pages of a view that is being fetched, stored under Saved/Gridly/Checkpoints as they arrive. If the fetch fails or
+ * is cancelled the pages are left in place, so the next fetch of the view only requests the pages that are missing.
+ *
+ * Each page is a file of its own, written to a temporary file first, so an interrupted write never leaves a damaged page.
+ */
+class GRIDLY_API FGridlyCheckpoint
+{
+public:
+	/** Kind separates the checkpoints of decoders with different page types, SchemaHash invalidates them when decoding changes */
+	FGridlyCheckpoint(const FString& Kind, const FString& ViewId, uint32 InSchemaHash, int32 InLimit);
+
+	/**
+	 * Reads the pages stored by an earlier fetch, and the total count of the view at the time. Returns false and discards
+	 * them if they were stored with a different schema or page size, or are older than MaxAge
+	 */
+	bool Resume(const FTimespan& MaxAge, TFunctionRef<TSharedRef<FGridlyPageData>()> CreatePage, int32& OutTotalCount,
+		TArray<TSharedRef<FGridlyPageData>>& OutPages);
+
+	/** Starts storing pages once the first page has returned the total count, replacing any pages stored before */
+	void Begin(int32 TotalCount);
+	void WritePage(FGridlyPageData& PageData);
+
+	/** Deletes the stored pages once every page of the view is fetched */
+	void Delete();
+
+private:
+	FString GetPagePath(int32 Offset) const;
+
+private:
+	FString Directory;
+	uint32 SchemaHash;
+	int32 Limit;
+	bool bBegun;
+};
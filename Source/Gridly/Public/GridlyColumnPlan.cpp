@@ -0,0 +1,121 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#include "GridlyColumnPlan.h"
+
+#include "Gridly.h"
+#include "GridlyCultureConverter.h"
+#include "GridlyGameSettings.h"
+
+FGridlyColumnPlan::FGridlyColumnPlan()
+{
+	const UGridlyGameSettings* GameSettings = GetDefault<UGridlyGameSettings>();
+
+	bUseCombinedNamespaceKey = GameSettings->bUseCombinedNamespaceId;
+	bUsePathAsNamespace = !bUseCombinedNamespaceKey && GameSettings->NamespaceColumnId == "path";
+	NamespaceColumnId = GameSettings->NamespaceColumnId;
+	SourceLanguageColumnIdPrefix = GameSettings->SourceLanguageColumnIdPrefix;
+	TargetLanguageColumnIdPrefix = GameSettings->TargetLanguageColumnIdPrefix;
+	TargetCultures = FGridlyCultureConverter::GetTargetCultures();
+}
+
+const FGridlyColumnPlan::FColumn& FGridlyColumnPlan::FindOrResolve(const FString& ColumnId, int32 Position)
+{
+	{
+		FReadScopeLock ReadScopeLock(Lock);
+
+		if (ColumnIndicesByPosition.IsValidIndex(Position))
+		{
+			const int32 ColumnIndex = ColumnIndicesByPosition[Position];
+			if (ColumnIndex != INDEX_NONE && Columns[ColumnIndex].ColumnId.Equals(ColumnId, ESearchCase::CaseSensitive))
+			{
+				return Columns[ColumnIndex];
+			}
+		}
+	}
+
+	// A column seen for the first time, or a record with a different cell order
+
+	FWriteScopeLock WriteScopeLock(Lock);
+
+	int32 ColumnIndex;
+	if (const int32* FoundColumnIndex = ColumnIndices.Find(ColumnId))
+	{
+		ColumnIndex = *FoundColumnIndex;
+	}
+	else
+	{
+		ColumnIndex = Columns.Add(new FColumn(ResolveColumn(ColumnId)));
+		ColumnIndices.Add(ColumnId, ColumnIndex);
+
+		UE_LOG(LogGridly, Verbose, TEXT("Column %s: role %d, culture %s"), *ColumnId, static_cast<int32>(Columns[ColumnIndex].Role),
+			*Columns[ColumnIndex].Culture);
+	}
+
+	if (Position >= 0)
+	{
+		while (ColumnIndicesByPosition.Num() <= Position)
+		{
+			ColumnIndicesByPosition.Add(INDEX_NONE);
+		}
+		ColumnIndicesByPosition[Position] = ColumnIndex;
+	}
+
+	return Columns[ColumnIndex];
+}
+
+bool FGridlyColumnPlan::GetMappedColumnIds(TArray<FString>& OutColumnIds) const
+{
+	if (TargetCultures.Num() == 0)
+	{
+		return false;
+	}
+
+	if (!bUsePathAsNamespace)
+	{
+		OutColumnIds.AddUnique(NamespaceColumnId);
+	}
+
+	for (const FString& Culture : TargetCultures)
+	{
+		FString GridlyCulture;
+		if (!FGridlyCultureConverter::ConvertToGridlyColumnCulture(TargetCultures, Culture, GridlyCulture))
+		{
+			UE_LOG(LogGridly, Log, TEXT("Requesting every column, since no Gridly culture resolves back to culture %s"), *Culture);
+			return false;
+		}
+
+		OutColumnIds.AddUnique(SourceLanguageColumnIdPrefix + GridlyCulture);
+		OutColumnIds.AddUnique(TargetLanguageColumnIdPrefix + GridlyCulture);
+	}
+
+	return true;
+}
+
+FGridlyColumnPlan::FColumn FGridlyColumnPlan::ResolveColumn(const FString& ColumnId) const
+{
+	FColumn Column;
+	Column.ColumnId = ColumnId;
+
+	if (!bUsePathAsNamespace && ColumnId == NamespaceColumnId)
+	{
+		Column.Role = EColumnRole::Namespace;
+	}
+	else if (ColumnId.StartsWith(SourceLanguageColumnIdPrefix))
+	{
+		const FString GridlyCulture = ColumnId.RightChop(SourceLanguageColumnIdPrefix.Len());
+		if (FGridlyCultureConverter::ConvertFromGridly(TargetCultures, GridlyCulture, Column.Culture))
+		{
+			Column.Role = EColumnRole::Source;
+		}
+	}
+	else if (ColumnId.StartsWith(TargetLanguageColumnIdPrefix))
+	{
+		const FString GridlyCulture = ColumnId.RightChop(TargetLanguageColumnIdPrefix.Len());
+		if (FGridlyCultureConverter::ConvertFromGridly(TargetCultures, GridlyCulture, Column.Culture))
+		{
+			Column.Role = EColumnRole::Target;
+		}
+	}
+
+	return Column;
+}
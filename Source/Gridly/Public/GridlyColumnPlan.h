@@ -0,0 +1,73 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Containers/IndirectArray.h"
+
+/**
+ * Role of each column of a view, resolved once from the column settings and reused for every record of the view. Cells
+ * are then dispatched on their resolved role, without matching prefixes or converting cultures per cell.
+ *
+ * Pages of a view are decoded concurrently, so the plan is shared between worker threads. It must be created on the game
+ * thread, since it reads the localization targets.
+ */
+class GRIDLY_API FGridlyColumnPlan
+{
+public:
+	enum class EColumnRole : uint8
+	{
+		Ignored,
+		Namespace,
+		Source,
+		Target
+	};
+
+	struct FColumn
+	{
+		FString ColumnId;
+		EColumnRole Role = EColumnRole::Ignored;
+		FString Culture;
+	};
+
+	/** Captures the column settings and target cultures in effect when the view is imported */
+	FGridlyColumnPlan();
+
+	FGridlyColumnPlan(const FGridlyColumnPlan&) = delete;
+	FGridlyColumnPlan& operator=(const FGridlyColumnPlan&) = delete;
+
+	/**
+	 * Returns the column with this ID, found at Position within its record. Records of a view list their cells in the same
+	 * order, so once the first record is resolved this is a single comparison against the column expected at Position
+	 */
+	const FColumn& FindOrResolve(const FString& ColumnId, int32 Position);
+
+	bool UsesCombinedNamespaceKey() const { return bUseCombinedNamespaceKey; }
+	bool UsesPathAsNamespace() const { return bUsePathAsNamespace; }
+
+	/**
+	 * Adds the ID of every column that can resolve to a role, so only those are requested from Gridly. Returns false when a
+	 * target culture has no Gridly culture that resolves back to it, since its columns can then only be matched once every
+	 * column is fetched
+	 */
+	bool GetMappedColumnIds(TArray<FString>& OutColumnIds) const;
+
+private:
+	FColumn ResolveColumn(const FString& ColumnId) const;
+
+private:
+	bool bUseCombinedNamespaceKey;
+	bool bUsePathAsNamespace;
+	FString NamespaceColumnId;
+	FString SourceLanguageColumnIdPrefix;
+	FString TargetLanguageColumnIdPrefix;
+	TArray<FString> TargetCultures;
+
+	FRWLock Lock;
+
+	/** Columns never move once resolved, so references to them stay valid while other threads add columns */
+	TIndirectArray<FColumn> Columns;
+	TMap<FString, int32> ColumnIndices;
+	TArray<int32> ColumnIndicesByPosition;
+};
@@ -11,9 +11,11 @@
 #include "LocalizationTargetTypes.h"
 #endif
 
-// For culture and regex handling
-#include "Internationalization/Regex.h"
+// For culture handling
 #include "Kismet/KismetInternationalizationLibrary.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Crc.h"
+#include "Misc/ScopeLock.h"
 
 // For logging
 #include "Logging/LogMacros.h"
@@ -22,42 +24,370 @@
 #include "Containers/Array.h"
 #include "Containers/UnrealString.h"
 
+namespace GridlyCultureConverter
+{
+	struct FCultureMappingEntry
+	{
+		const TCHAR* Culture;
+		const TCHAR* GridlyCulture;
+	};
+
+	// Default value of UGridlyGameSettings::CustomCultureMapping
+
+	static constexpr FCultureMappingEntry DefaultCultureMapping[] =
+	{
+		{TEXT("en-US"), TEXT("enUS")},
+		{TEXT("ar-SA"), TEXT("arSA")},
+		{TEXT("ca-ES"), TEXT("caES")},
+		{TEXT("zh-CN"), TEXT("zhCN")},
+		{TEXT("zh-TW"), TEXT("zhTW")},
+		{TEXT("de-DE"), TEXT("deDE")},
+		{TEXT("it-IT"), TEXT("itIT")},
+		{TEXT("ja-JP"), TEXT("jaJP")},
+		{TEXT("ko-KR"), TEXT("koKR")},
+		{TEXT("pl-PL"), TEXT("plPL")},
+		{TEXT("pt-BR"), TEXT("ptBR")},
+		{TEXT("ru-RU"), TEXT("ruRU")},
+		{TEXT("es-MX"), TEXT("esMX")},
+		{TEXT("es-ES"), TEXT("esES")},
+		{TEXT("bn-BD"), TEXT("bnBD")},
+		{TEXT("bg-BG"), TEXT("bgBG")},
+		{TEXT("zh-HK"), TEXT("zhHK")},
+		{TEXT("cs-CZ"), TEXT("csCZ")},
+		{TEXT("da-DK"), TEXT("daDK")},
+		{TEXT("nl-NL"), TEXT("nlNL")},
+		{TEXT("fi-FI"), TEXT("fiFI")},
+		{TEXT("fr-CA"), TEXT("frCA")},
+		{TEXT("fr-FR"), TEXT("frFR")},
+		{TEXT("el-GR"), TEXT("elGR")},
+		{TEXT("he-IL"), TEXT("heIL")},
+		{TEXT("hi-IN"), TEXT("hiIN")},
+		{TEXT("hu-HU"), TEXT("huHU")},
+		{TEXT("id-ID"), TEXT("idID")},
+		{TEXT("jw-ID"), TEXT("jwID")},
+		{TEXT("lv-LV"), TEXT("lvLV")},
+		{TEXT("ms-MY"), TEXT("msMY")},
+		{TEXT("no-NO"), TEXT("noNO")},
+		{TEXT("pt-PT"), TEXT("ptPT")},
+		{TEXT("ro-RO"), TEXT("roRO")},
+		{TEXT("sk-SK"), TEXT("skSK")},
+		{TEXT("sv-SE"), TEXT("svSE")},
+		{TEXT("tl-PH"), TEXT("tlPH")},
+		{TEXT("th-TH"), TEXT("thTH")},
+		{TEXT("tr-TR"), TEXT("trTR")},
+		{TEXT("uk-UA"), TEXT("ukUA")},
+		{TEXT("ur-IN"), TEXT("urIN")},
+		{TEXT("vi-VN"), TEXT("viVN")},
+		{TEXT("af-ZA"), TEXT("afZA")},
+		{TEXT("ar-AE"), TEXT("arAE")},
+		{TEXT("ar-BH"), TEXT("arBH")},
+		{TEXT("ar-DZ"), TEXT("arDZ")},
+		{TEXT("ar-EG"), TEXT("arEG")},
+		{TEXT("ar-IQ"), TEXT("arIQ")},
+		{TEXT("ar-JO"), TEXT("arJO")},
+		{TEXT("ar-KW"), TEXT("arKW")},
+		{TEXT("ar-LB"), TEXT("arLB")},
+		{TEXT("ar-LY"), TEXT("arLY")},
+		{TEXT("ar-MA"), TEXT("arMA")},
+		{TEXT("ar-OM"), TEXT("arOM")},
+		{TEXT("ar-QA"), TEXT("arQA")},
+		{TEXT("ar-SY"), TEXT("arSY")},
+		{TEXT("ar-TN"), TEXT("arTN")},
+		{TEXT("ar-YE"), TEXT("arYE")},
+		{TEXT("az-AZ"), TEXT("azAZ")},
+		{TEXT("be-BY"), TEXT("beBY")},
+		{TEXT("bs-BA"), TEXT("bsBA")},
+		{TEXT("cy-GB"), TEXT("cyGB")},
+		{TEXT("de-AT"), TEXT("deAT")},
+		{TEXT("de-CH"), TEXT("deCH")},
+		{TEXT("de-LI"), TEXT("deLI")},
+		{TEXT("de-LU"), TEXT("deLU")},
+		{TEXT("dv-MV"), TEXT("dvMV")},
+		{TEXT("en-AU"), TEXT("enAU")},
+		{TEXT("en-BZ"), TEXT("enBZ")},
+		{TEXT("en-CA"), TEXT("enCA")},
+		{TEXT("en-GB"), TEXT("enGB")},
+		{TEXT("en-IE"), TEXT("enIE")},
+		{TEXT("en-JM"), TEXT("enJM")},
+		{TEXT("en-NZ"), TEXT("enNZ")},
+		{TEXT("en-PH"), TEXT("enPH")},
+		{TEXT("en-TT"), TEXT("enTT")},
+		{TEXT("en-ZA"), TEXT("enZA")},
+		{TEXT("en-ZW"), TEXT("enZW")},
+		{TEXT("es-AR"), TEXT("esAR")},
+		{TEXT("es-BO"), TEXT("esBO")},
+		{TEXT("es-CL"), TEXT("esCL")},
+		{TEXT("es-CO"), TEXT("esCO")},
+		{TEXT("es-CR"), TEXT("esCR")},
+		{TEXT("es-DO"), TEXT("esDO")},
+		{TEXT("es-EC"), TEXT("esEC")},
+		{TEXT("es-GT"), TEXT("esGT")},
+		{TEXT("es-HN"), TEXT("esHN")},
+		{TEXT("es-NI"), TEXT("esNI")},
+		{TEXT("es-PA"), TEXT("esPA")},
+		{TEXT("es-PE"), TEXT("esPE")},
+		{TEXT("es-PR"), TEXT("esPR")},
+		{TEXT("es-PY"), TEXT("esPY")},
+		{TEXT("es-SV"), TEXT("esSV")},
+		{TEXT("es-UY"), TEXT("esUY")},
+		{TEXT("es-VE"), TEXT("esVE")},
+		{TEXT("et-EE"), TEXT("etEE")},
+		{TEXT("eu-ES"), TEXT("euES")},
+		{TEXT("fa-IR"), TEXT("faIR")},
+		{TEXT("fo-FO"), TEXT("foFO")},
+		{TEXT("fr-BE"), TEXT("frBE")},
+		{TEXT("fr-CH"), TEXT("frCH")},
+		{TEXT("fr-LU"), TEXT("frLU")},
+		{TEXT("fr-MC"), TEXT("frMC")},
+		{TEXT("gl-ES"), TEXT("glES")},
+		{TEXT("gu-IN"), TEXT("guIN")},
+		{TEXT("hr-BA"), TEXT("hrBA")},
+		{TEXT("hr-HR"), TEXT("hrHR")},
+		{TEXT("hy-AM"), TEXT("hyAM")},
+		{TEXT("is-IS"), TEXT("isIS")},
+		{TEXT("it-CH"), TEXT("itCH")},
+		{TEXT("ka-GE"), TEXT("kaGE")},
+		{TEXT("kk-KZ"), TEXT("kkKZ")},
+		{TEXT("kn-IN"), TEXT("knIN")},
+		{TEXT("kok-IN"), TEXT("kokIN")},
+		{TEXT("ky-KG"), TEXT("kyKG")},
+		{TEXT("lt-LT"), TEXT("ltLT")},
+		{TEXT("mi-NZ"), TEXT("miNZ")},
+		{TEXT("mk-MK"), TEXT("mkMK")},
+		{TEXT("mn-MN"), TEXT("mnMN")},
+		{TEXT("mr-IN"), TEXT("mrIN")},
+		{TEXT("ms-BN"), TEXT("msBN")},
+		{TEXT("mt-MT"), TEXT("mtMT")},
+		{TEXT("nb-NO"), TEXT("nbNO")},
+		{TEXT("nl-BE"), TEXT("nlBE")},
+		{TEXT("nn-NO"), TEXT("nnNO")},
+		{TEXT("ns-ZA"), TEXT("nsZA")},
+		{TEXT("pa-IN"), TEXT("paIN")},
+		{TEXT("ps-AR"), TEXT("psAR")},
+		{TEXT("qu-BO"), TEXT("quBO")},
+		{TEXT("qu-EC"), TEXT("quEC")},
+		{TEXT("qu-PE"), TEXT("quPE")},
+		{TEXT("sa-IN"), TEXT("saIN")},
+		{TEXT("se-FI"), TEXT("seFI")},
+		{TEXT("se-NO"), TEXT("seNO")},
+		{TEXT("se-SE"), TEXT("seSE")},
+		{TEXT("sl-SI"), TEXT("slSI")},
+		{TEXT("sq-AL"), TEXT("sqAL")},
+		{TEXT("sr-BA"), TEXT("srBA")},
+		{TEXT("sv-FI"), TEXT("svFI")},
+		{TEXT("sw-KE"), TEXT("swKE")},
+		{TEXT("syr-SY"), TEXT("syrSY")},
+		{TEXT("ta-IN"), TEXT("taIN")},
+		{TEXT("te-IN"), TEXT("teIN")},
+		{TEXT("tn-ZA"), TEXT("tnZA")},
+		{TEXT("tt-RU"), TEXT("ttRU")},
+		{TEXT("ur-PK"), TEXT("urPK")},
+		{TEXT("uz-UZ"), TEXT("uzUZ")},
+		{TEXT("xh-ZA"), TEXT("xhZA")},
+		{TEXT("zh-MO"), TEXT("zhMO")},
+		{TEXT("zh-SG"), TEXT("zhSG")},
+		{TEXT("zu-ZA"), TEXT("zuZA")},
+	};
+
+	/** Lookups built from the settings and localization targets, rebuilt when either of them changes */
+	struct FCultureCache
+	{
+		FCriticalSection Lock;
+
+		bool bHasCultureMapping = false;
+		uint32 CultureMappingSignature = 0;
+		TMap<FString, FString> CultureToGridly;
+		TMap<FString, FString> GridlyToCulture;
+
+		bool bHasTargetCultures = false;
+		uint32 TargetCulturesSignature = 0;
+		TArray<FString> TargetCultures;
+	};
+
+	FCultureCache& GetCultureCache()
+	{
+		static FCultureCache CultureCache;
+		return CultureCache;
+	}
+
+	// The settings can change at runtime or on a config reload without the editor settings being saved, so the lookups are
+	// rebuilt whenever the signature of the mapping no longer matches the one they were built from
+
+	uint32 GetCultureMappingSignature(const UGridlyGameSettings* GameSettings)
+	{
+		const bool bUseCustomCultureMapping = GameSettings->bUseCustomCultureMapping;
+		uint32 Signature = FCrc::MemCrc32(&bUseCustomCultureMapping, sizeof(bUseCustomCultureMapping));
+
+		if (bUseCustomCultureMapping)
+		{
+			for (const TPair<FString, FString>& Pair : GameSettings->CustomCultureMapping)
+			{
+				const int32 Lengths[] = {Pair.Key.Len(), Pair.Value.Len()};
+				Signature = FCrc::MemCrc32(Lengths, sizeof(Lengths), Signature);
+				Signature = FCrc::StrCrc32(*Pair.Key, Signature);
+				Signature = FCrc::StrCrc32(*Pair.Value, Signature);
+			}
+		}
+
+		return Signature;
+	}
+
+	void UpdateCultureMapping(FCultureCache& CultureCache)
+	{
+		const UGridlyGameSettings* GameSettings = GetDefault<UGridlyGameSettings>();
+		const uint32 Signature = GetCultureMappingSignature(GameSettings);
+
+		if (CultureCache.bHasCultureMapping && CultureCache.CultureMappingSignature == Signature)
+		{
+			return;
+		}
+
+		CultureCache.CultureToGridly.Reset();
+		CultureCache.GridlyToCulture.Reset();
+
+		if (GameSettings->bUseCustomCultureMapping)
+		{
+			for (const TPair<FString, FString>& Pair : GameSettings->CustomCultureMapping)
+			{
+				CultureCache.CultureToGridly.Add(Pair.Key, Pair.Value);
+
+				// Like TMap::FindKey, the first culture mapped to a Gridly culture wins
+				if (!CultureCache.GridlyToCulture.Contains(Pair.Value))
+				{
+					CultureCache.GridlyToCulture.Add(Pair.Value, Pair.Key);
+				}
+			}
+		}
+
+		CultureCache.bHasCultureMapping = true;
+		CultureCache.CultureMappingSignature = Signature;
+	}
+
+	// Same as matching "([a-z]+)([A-Z]+)": the first run of lowercase letters directly followed by uppercase letters
+
+	bool SplitGridlyCulture(const FString& GridlyCulture, FStringView& OutLanguage, FStringView& OutRegion)
+	{
+		const TCHAR* Data = *GridlyCulture;
+		const int32 Len = GridlyCulture.Len();
+
+		int32 Pos = 0;
+		while (Pos < Len)
+		{
+			if (Data[Pos] < TEXT('a') || Data[Pos] > TEXT('z'))
+			{
+				Pos++;
+				continue;
+			}
+
+			const int32 LanguageStart = Pos;
+			while (Pos < Len && Data[Pos] >= TEXT('a') && Data[Pos] <= TEXT('z'))
+			{
+				Pos++;
+			}
+
+			const int32 RegionStart = Pos;
+			while (Pos < Len && Data[Pos] >= TEXT('A') && Data[Pos] <= TEXT('Z'))
+			{
+				Pos++;
+			}
+
+			if (Pos > RegionStart)
+			{
+				OutLanguage = FStringView(Data + LanguageStart, RegionStart - LanguageStart);
+				OutRegion = FStringView(Data + RegionStart, Pos - RegionStart);
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
+
+TMap<FString, FString> FGridlyCultureConverter::GetDefaultCultureMapping()
+{
+	TMap<FString, FString> CultureMapping;
+	CultureMapping.Reserve(UE_ARRAY_COUNT(GridlyCultureConverter::DefaultCultureMapping));
+
+	for (const GridlyCultureConverter::FCultureMappingEntry& Entry : GridlyCultureConverter::DefaultCultureMapping)
+	{
+		CultureMapping.Add(Entry.Culture, Entry.GridlyCulture);
+	}
+
+	return CultureMapping;
+}
+
+void FGridlyCultureConverter::InvalidateCultureMapping()
+{
+	GridlyCultureConverter::FCultureCache& CultureCache = GridlyCultureConverter::GetCultureCache();
+
+	FScopeLock ScopeLock(&CultureCache.Lock);
+	CultureCache.bHasCultureMapping = false;
+}
+
 TArray<FString> FGridlyCultureConverter::GetTargetCultures()
 {
-	TArray<FString> TargetCultures;
+	GridlyCultureConverter::FCultureCache& CultureCache = GridlyCultureConverter::GetCultureCache();
 
 #if WITH_EDITOR
-	TArray<ULocalizationTarget*> LocalizationTargets = ULocalizationSettings::GetGameTargetSet()->TargetObjects;
+	// The cultures are cached until a target or culture is added, removed or renamed
 
-	FString CulturesString;
+	const TArray<ULocalizationTarget*>& LocalizationTargets = ULocalizationSettings::GetGameTargetSet()->TargetObjects;
 
-	for (int i = 0; i < LocalizationTargets.Num(); i++)
+	uint32 Signature = 0;
+	for (const ULocalizationTarget* LocalizationTarget : LocalizationTargets)
 	{
-		TArray<FCultureStatistics> CultureStatistics = LocalizationTargets[i]->Settings.SupportedCulturesStatistics;
-		for (int j = 0; j < CultureStatistics.Num(); j++)
+		if (LocalizationTarget)
 		{
-			const FString& Culture = CultureStatistics[j].CultureName;
-			TargetCultures.Add(Culture);
-
-			if (CulturesString.Len() > 0)
+			for (const FCultureStatistics& CultureStatistics : LocalizationTarget->Settings.SupportedCulturesStatistics)
 			{
-				CulturesString.Append(", ");
+				Signature = FCrc::StrCrc32(*CultureStatistics.CultureName, Signature);
 			}
-			CulturesString.Append(Culture);
 		}
+
+		const int32 NumCultures = LocalizationTarget ? LocalizationTarget->Settings.SupportedCulturesStatistics.Num() : 0;
+		Signature = FCrc::MemCrc32(&NumCultures, sizeof(NumCultures), Signature);
 	}
 
-	UE_LOG(LogGridly, Verbose, TEXT("Available cultures: %s"), *CulturesString);
+	FScopeLock ScopeLock(&CultureCache.Lock);
+
+	if (!CultureCache.bHasTargetCultures || CultureCache.TargetCulturesSignature != Signature)
+	{
+		CultureCache.TargetCultures.Reset();
+
+		for (const ULocalizationTarget* LocalizationTarget : LocalizationTargets)
+		{
+			if (LocalizationTarget)
+			{
+				for (const FCultureStatistics& CultureStatistics : LocalizationTarget->Settings.SupportedCulturesStatistics)
+				{
+					CultureCache.TargetCultures.Add(CultureStatistics.CultureName);
+				}
+			}
+		}
+
+		CultureCache.bHasTargetCultures = true;
+		CultureCache.TargetCulturesSignature = Signature;
+
+		UE_LOG(LogGridly, Verbose, TEXT("Available cultures: %s"), *FString::Join(CultureCache.TargetCultures, TEXT(", ")));
+	}
 #else
-	TargetCultures = FTextLocalizationManager::Get().GetLocalizedCultureNames(ELocalizationLoadFlags::Game);
+	FScopeLock ScopeLock(&CultureCache.Lock);
 
-	for (int i = 0; i < TargetCultures.Num(); i++)
+	// Only cached once the localization manager has loaded the game cultures
+
+	if (!CultureCache.bHasTargetCultures)
 	{
-		UE_LOG(LogGridly, Log, TEXT("Culture: %s"), *TargetCultures[i]);
+		CultureCache.TargetCultures = FTextLocalizationManager::Get().GetLocalizedCultureNames(ELocalizationLoadFlags::Game);
+		CultureCache.bHasTargetCultures = CultureCache.TargetCultures.Num() > 0;
+
+		for (int i = 0; i < CultureCache.TargetCultures.Num(); i++)
+		{
+			UE_LOG(LogGridly, Log, TEXT("Culture: %s"), *CultureCache.TargetCultures[i]);
+		}
 	}
 #endif
 
-	return TargetCultures;
+	return CultureCache.TargetCultures;
 }
 
 bool FGridlyCultureConverter::ConvertFromGridly(
@@ -67,11 +397,13 @@ bool FGridlyCultureConverter::ConvertFromGridly(
 	{
 		// Use custom mapping if it is available
 
-		UGridlyGameSettings* GameSettings = GetMutableDefault<UGridlyGameSettings>();
-
-		if (GameSettings->bUseCustomCultureMapping)
 		{
-			const FString* CustomCulture = GameSettings->CustomCultureMapping.FindKey(GridlyCulture);
+			GridlyCultureConverter::FCultureCache& CultureCache = GridlyCultureConverter::GetCultureCache();
+			FScopeLock ScopeLock(&CultureCache.Lock);
+
+			GridlyCultureConverter::UpdateCultureMapping(CultureCache);
+
+			const FString* CustomCulture = CultureCache.GridlyToCulture.Find(GridlyCulture);
 
 			if (CustomCulture != nullptr)
 			{
@@ -81,13 +413,13 @@ bool FGridlyCultureConverter::ConvertFromGridly(
 		}
 
 		// Otherwise follow rules of "enUS" -> "en-US"
-		
-		FString Culture = GridlyCulture;
-		const FRegexPattern RegexPattern("([a-z]+)([A-Z]+)");
-		FRegexMatcher RegexMatcher(RegexPattern, GridlyCulture);
-		if (RegexMatcher.FindNext())
+
+		FStringView Language;
+		FStringView Region;
+		if (GridlyCultureConverter::SplitGridlyCulture(GridlyCulture, Language, Region))
 		{
-			Culture = RegexMatcher.GetCaptureGroup(1) + "-" + RegexMatcher.GetCaptureGroup(2);
+			const FString Culture = FString::Printf(TEXT("%.*s-%.*s"), Language.Len(), Language.GetData(), Region.Len(),
+				Region.GetData());
 			OutCulture = UKismetInternationalizationLibrary::GetSuitableCulture(AvailableCultures, Culture, TEXT(""));
 			return true;
 		}
@@ -102,11 +434,13 @@ bool FGridlyCultureConverter::ConvertToGridly(const FString& Culture, FString& O
 	{
 		// Use custom mapping if it is available
 
-		UGridlyGameSettings* GameSettings = GetMutableDefault<UGridlyGameSettings>();
-
-		if (GameSettings->bUseCustomCultureMapping)
 		{
-			const FString* CustomCulture = GameSettings->CustomCultureMapping.Find(Culture);
+			GridlyCultureConverter::FCultureCache& CultureCache = GridlyCultureConverter::GetCultureCache();
+			FScopeLock ScopeLock(&CultureCache.Lock);
+
+			GridlyCultureConverter::UpdateCultureMapping(CultureCache);
+
+			const FString* CustomCulture = CultureCache.CultureToGridly.Find(Culture);
 
 			if (CustomCulture != nullptr)
 			{
@@ -117,13 +451,49 @@ bool FGridlyCultureConverter::ConvertToGridly(const FString& Culture, FString& O
 
 		// Otherwise follow rules of "en-US" -> "enUS"
 
-		FString Left, Right;
-		if (Culture.Split("-", &Left, &Right))
+		int32 SeparatorIndex;
+		if (Culture.FindChar(TEXT('-'), SeparatorIndex))
 		{
-			OutGridlyCulture = Left + Right;
+			OutGridlyCulture.Reset(Culture.Len() - 1);
+			OutGridlyCulture.AppendChars(*Culture, SeparatorIndex);
+			OutGridlyCulture.AppendChars(*Culture + SeparatorIndex + 1, Culture.Len() - SeparatorIndex - 1);
 			return true;
 		}
 	}
 
 	return false;
 }
+
+bool FGridlyCultureConverter::ConvertToGridlyColumnCulture(
+	const TArray<FString>& AvailableCultures, const FString& Culture, FString& OutGridlyCulture)
+{
+	// The conversions are not inverses: zh-Hans converts to zhHans, while it is zhCN that resolves to zh-Hans
+
+	FString ResolvedCulture;
+	return ConvertToGridly(Culture, OutGridlyCulture) && ConvertFromGridly(AvailableCultures, OutGridlyCulture, ResolvedCulture)
+	       && ResolvedCulture == Culture;
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridlyColumnCultureTest, "Gridly.CultureConverter.ColumnCulture",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FGridlyColumnCultureTest::RunTest(const FString& Parameters)
+{
+	const TArray<FString> AvailableCultures = {TEXT("en"), TEXT("fr-FR"), TEXT("zh-Hans")};
+
+	FString GridlyCulture;
+	TestTrue(TEXT("fr-FR has a column culture"),
+		FGridlyCultureConverter::ConvertToGridlyColumnCulture(AvailableCultures, TEXT("fr-FR"), GridlyCulture));
+	TestEqual(TEXT("fr-FR column culture"), GridlyCulture, FString(TEXT("frFR")));
+
+	TestFalse(TEXT("zh-Hans has no column culture"),
+		FGridlyCultureConverter::ConvertToGridlyColumnCulture(AvailableCultures, TEXT("zh-Hans"), GridlyCulture));
+	TestFalse(TEXT("en has no column culture"),
+		FGridlyCultureConverter::ConvertToGridlyColumnCulture(AvailableCultures, TEXT("en"), GridlyCulture));
+
+	return true;
+}
+
+#endif
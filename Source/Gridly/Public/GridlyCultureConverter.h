@@ -7,8 +7,27 @@
 class GRIDLY_API FGridlyCultureConverter
 {
 public:
+	/** Cached until a localization target or culture is added, removed or renamed */
 	static TArray<FString> GetTargetCultures();
+
+	/**
+	 * Custom mappings are looked up in hash maps built from the settings, rebuilt whenever the mapping or whether it is used
+	 * changes, or after InvalidateCultureMapping
+	 */
 	static bool ConvertFromGridly(const TArray<FString>& AvailableCultures, const FString& GridlyCulture,
 		FString& OutCulture);
 	static bool ConvertToGridly(const FString& Culture, FString& OutGridlyCulture);
+
+	/**
+	 * Same as ConvertToGridly, but fails unless ConvertFromGridly maps the Gridly culture back to Culture. Columns are resolved
+	 * with ConvertFromGridly, so only then is a column named after the Gridly culture matched to this culture
+	 */
+	static bool ConvertToGridlyColumnCulture(const TArray<FString>& AvailableCultures, const FString& Culture,
+		FString& OutGridlyCulture);
+
+	/** The mapping UGridlyGameSettings::CustomCultureMapping starts with */
+	static TMap<FString, FString> GetDefaultCultureMapping();
+
+	/** Called when the culture mapping settings change */
+	static void InvalidateCultureMapping();
 };
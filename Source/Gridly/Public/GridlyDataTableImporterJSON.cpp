@@ -45,6 +45,28 @@ FString GetKeyFieldName(const UDataTable& InDataTable)
 		return ExplicitString;
 	}
 }
+
+void GetImportColumnIds(const UDataTable& InDataTable, TArray<FString>& OutColumnIds)
+{
+	if (!InDataTable.RowStruct)
+	{
+		return;
+	}
+
+	TArray<FString> TempPropertyImportNames;
+	for (TFieldIterator<FProperty> It(InDataTable.RowStruct); It; ++It)
+	{
+#if ENGINE_MINOR_VERSION >= 26
+		DataTableUtils::GetPropertyImportNames(*It, TempPropertyImportNames);
+#else
+		TempPropertyImportNames = DataTableUtils::GetPropertyImportNames(*It);
+#endif
+		for (const FString& PropertyName : TempPropertyImportNames)
+		{
+			OutColumnIds.AddUnique(PropertyName);
+		}
+	}
+}
 }
 
 FGridlyDataTableImporterJSON::FGridlyDataTableImporterJSON(UDataTable& InDataTable, const FString& InJSONData, TArray<FString>& OutProblems) :
@@ -10,6 +10,9 @@
 namespace GridlyDataTableJSONUtils
 {
 	FString GRIDLY_API GetKeyFieldName(const UDataTable& InDataTable);
+
+	/** Adds every name a column can have to be imported into a property of the row struct */
+	void GRIDLY_API GetImportColumnIds(const UDataTable& InDataTable, TArray<FString>& OutColumnIds);
 }
 
 class GRIDLY_API FGridlyDataTableImporterJSON
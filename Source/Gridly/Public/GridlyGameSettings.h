@@ -13,6 +13,15 @@ enum class EGridlyColumnDataType : uint8
     Number
 };
 
+UENUM(BlueprintType)
+enum class EGridlyDuplicatePolicy : uint8
+{
+    /** The first record imported with a key is kept, later ones are ignored */
+    FirstWins,
+    /** Each record imported with a key replaces the previous one */
+    LastWins
+};
+
 USTRUCT(BlueprintType)
 struct GRIDLY_API FGridlyColumnInfo
 {
@@ -37,14 +46,64 @@ public:
     UPROPERTY(Category = "Gridly|Import Settings", BlueprintReadOnly, EditAnywhere, Config)
     FString ImportApiKey;
 
-    /** The view IDs to fetch from Gridly. Record IDs will be combined. Duplicate keys will be ignored */
+    /** The view IDs to fetch from Gridly. Record IDs will be combined. Duplicate keys are resolved by ImportDuplicatePolicy */
     UPROPERTY(Category = "Gridly|Import Settings", BlueprintReadOnly, EditAnywhere, Config)
     TArray<FString> ImportFromViewIds;
 
+    /** Which record to keep when several pages or views contain the same namespace and key, or the same record ID for data tables */
+    UPROPERTY(Category = "Gridly|Import Settings", BlueprintReadOnly, EditAnywhere, Config)
+    EGridlyDuplicatePolicy ImportDuplicatePolicy = EGridlyDuplicatePolicy::FirstWins;
+
     /** The max amount of records to import on each request. This should normally be set to the API limit */
     UPROPERTY(Category = "Gridly|Import Settings|Advanced", BlueprintReadOnly, EditAnywhere, Config, meta = (ClampMin = "1", ClampMax = "1000"))
     int ImportMaxRecordsPerRequest = 1000;
 
+    /** The max amount of page requests that can be in flight at the same time once the size of a view is known */
+    UPROPERTY(Category = "Gridly|Import Settings|Advanced", BlueprintReadOnly, EditAnywhere, Config, meta = (ClampMin = "1", ClampMax = "16"))
+    int ImportMaxConcurrentRequests = 4;
+
+    /** Keeps a snapshot of each imported view under Saved/Gridly/Snapshots, with per-record hashes to report what changed between imports */
+    UPROPERTY(Category = "Gridly|Import Settings|Advanced", BlueprintReadOnly, EditAnywhere, Config)
+    bool bUseImportSnapshots = true;
+
+    /** A snapshot younger than this is imported without contacting Gridly. Set to 0 to always fetch the views */
+    UPROPERTY(Category = "Gridly|Import Settings|Advanced", BlueprintReadOnly, EditAnywhere, Config,
+        meta = (EditCondition = "bUseImportSnapshots", ClampMin = "0", Units = "Minutes"))
+    float ImportSnapshotMaxAgeMinutes = 0.f;
+
+    /** Keeps the pages of each view being imported under Saved/Gridly/Checkpoints until the view is fully fetched, so an import that fails or is cancelled resumes from the first missing page */
+    UPROPERTY(Category = "Gridly|Import Settings|Advanced", BlueprintReadOnly, EditAnywhere, Config)
+    bool bUseImportCheckpoints = true;
+
+    /** Checkpoints older than this are discarded, and the view is fetched from the start */
+    UPROPERTY(Category = "Gridly|Import Settings|Advanced", BlueprintReadOnly, EditAnywhere, Config,
+        meta = (EditCondition = "bUseImportCheckpoints", ClampMin = "0", Units = "Minutes"))
+    float ImportCheckpointMaxAgeMinutes = 1440.f;
+
+    /** The max amount of times a page is requested again after its request fails or its response cannot be decoded, before the import gives up */
+    UPROPERTY(Category = "Gridly|Import Settings|Advanced", BlueprintReadOnly, EditAnywhere, Config, meta = (ClampMin = "0", ClampMax = "20"))
+    int ImportMaxPageRetries = 3;
+
+    /** Leaves the .po file of a culture untouched when its contents have not changed since the last import, and skips importing the target when no culture changed */
+    UPROPERTY(Category = "Gridly|Import Settings|Advanced", BlueprintReadOnly, EditAnywhere, Config)
+    bool bSkipUnchangedCultures = true;
+
+    /** Imports downloaded translations into the target's archives within this process. When unset, or if the in-process import fails, the import and word count commandlets are run in a separate editor process */
+    UPROPERTY(Category = "Gridly|Import Settings|Advanced", BlueprintReadOnly, EditAnywhere, Config)
+    bool bImportInProcess = true;
+
+    /** Keeps at most this many megabytes of downloaded texts in memory. The rest is spilled to segment files under Saved/Gridly/Segments, which the .po files and archives are then written from. Set to 0 to keep every text in memory */
+    UPROPERTY(Category = "Gridly|Import Settings|Advanced", BlueprintReadOnly, EditAnywhere, Config, meta = (ClampMin = "0", Units = "Megabytes"))
+    int ImportMemoryBudgetMB = 0;
+
+    /** Requests only the columns an import maps to a culture, namespace or data table property, instead of every column of the view */
+    UPROPERTY(Category = "Gridly|Import Settings|Advanced", BlueprintReadOnly, EditAnywhere, Config)
+    bool bImportMappedColumnsOnly = true;
+
+    /** Passes everything downloaded so far to OnProgress after each page. Unset to only report each page on its own, through OnPage and OnPageDelegate */
+    UPROPERTY(Category = "Gridly|Import Settings|Advanced", BlueprintReadOnly, EditAnywhere, Config)
+    bool bBroadcastAccumulatedProgress = true;
+
     /** The API key can be retrieved from your Gridly dashboard. Make sure you have write access */
     UPROPERTY(Category = "Gridly|Export Settings", BlueprintReadOnly, EditAnywhere, Transient)
     FString ExportApiKey;
@@ -57,6 +116,29 @@ public:
     UPROPERTY(Category = "Gridly|Export Settings|Advanced", BlueprintReadOnly, EditAnywhere, Config, meta = (ClampMin = "1", ClampMax = "1000"))
     int ExportMaxRecordsPerRequest = 1000;
 
+    /** The max amount of export requests in flight at the same time. Further requests are only created as earlier ones complete */
+    UPROPERTY(Category = "Gridly|Export Settings|Advanced", BlueprintReadOnly, EditAnywhere, Config, meta = (ClampMin = "1", ClampMax = "16"))
+    int ExportMaxConcurrentRequests = 4;
+
+    /** How many times a failed export request is retried before the export fails */
+    UPROPERTY(Category = "Gridly|Export Settings|Advanced", BlueprintReadOnly, EditAnywhere, Config, meta = (ClampMin = "0", ClampMax = "20"))
+    int ExportMaxChunkRetries = 3;
+
+    /**
+     * Only exports the records that changed since the last export to the view, as recorded in Saved/Gridly/ExportManifests.
+     * Unchanged local texts are not re-sent, so edits made on Gridly or exports from another machine are not overwritten
+     */
+    UPROPERTY(Category = "Gridly|Export Settings|Advanced", BlueprintReadOnly, EditAnywhere, Config)
+    bool bUseDeltaExport = false;
+
+    /** Sends only the changed cells of a changed record, rather than the whole record */
+    UPROPERTY(Category = "Gridly|Export Settings|Advanced", BlueprintReadOnly, EditAnywhere, Config, meta = (EditCondition = "bUseDeltaExport"))
+    bool bExportChangedCellsOnly = false;
+
+    /** Exports every record regardless of the last export, e.g. after records were edited or deleted on Gridly. The manifest is still updated */
+    UPROPERTY(Category = "Gridly|Export Settings|Advanced", BlueprintReadOnly, EditAnywhere, Config, meta = (EditCondition = "bUseDeltaExport"))
+    bool bForceFullExport = false;
+
     /** Use combined comma-separated "{namespace},{key}" as record ID. WARNING! This should not be changed after a project has already been exported */
     UPROPERTY(Category = "Gridly|Options", BlueprintReadOnly, EditAnywhere, Config)
     bool bUseCombinedNamespaceId = false;
@@ -109,6 +191,30 @@ public:
     UPROPERTY(Category = "Gridly|Options", BlueprintReadOnly, EditAnywhere, Config, meta = (EditCondition = "bExportMetadata"))
     TMap<FString, FGridlyColumnInfo> MetadataMapping;
 
+    /** The rate all requests to Gridly start at. The rate grows while the API responds normally, and is halved when it asks to slow down */
+    UPROPERTY(Category = "Gridly|Options|Network", BlueprintReadOnly, EditAnywhere, Config, meta = (ClampMin = "0.1", ClampMax = "100"))
+    float ApiInitialRequestsPerSecond = 2.f;
+
+    /** The rate all requests to Gridly are allowed to grow to */
+    UPROPERTY(Category = "Gridly|Options|Network", BlueprintReadOnly, EditAnywhere, Config, meta = (ClampMin = "0.1", ClampMax = "100"))
+    float ApiMaxRequestsPerSecond = 10.f;
+
+    /** The max amount of times a request is retried when Gridly responds with 429 or 503 */
+    UPROPERTY(Category = "Gridly|Options|Network", BlueprintReadOnly, EditAnywhere, Config, meta = (ClampMin = "0", ClampMax = "20"))
+    int ApiMaxRetries = 5;
+
+    /** Base URL of the Gridly API. Can be pointed at a local stand-in server for testing */
+    UPROPERTY(Category = "Gridly|Options|Network", BlueprintReadOnly, EditAnywhere, Config)
+    FString ApiBaseUrl = "https://api.gridly.com";
+
+    /** Asks Gridly for gzip-compressed responses, which are decompressed transparently */
+    UPROPERTY(Category = "Gridly|Options|Network", BlueprintReadOnly, EditAnywhere, Config)
+    bool bAcceptCompressedResponses = false;
+
+    /** Sends export and delete request bodies gzip-compressed, with Content-Encoding: gzip */
+    UPROPERTY(Category = "Gridly|Options|Network", BlueprintReadOnly, EditAnywhere, Config)
+    bool bCompressRequestBodies = false;
+
 public:
     UGridlyGameSettings(const FObjectInitializer& ObjectInitializer);
 
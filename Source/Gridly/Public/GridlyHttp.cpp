@@ -0,0 +1,175 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#include "GridlyHttp.h"
+
+#include "Gridly.h"
+#include "GridlyGameSettings.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Misc/Compression.h"
+
+// Bodies smaller than this are sent as they are, since the gzip framing outweighs the savings
+static constexpr int32 GridlyMinCompressedContentSize = 1024;
+
+// Upper bound for the decompressed size stated in the gzip trailer, to reject corrupt responses
+static constexpr uint32 GridlyMaxDecompressedContentSize = 1024 * 1024 * 1024;
+
+FString FGridlyHttp::GetApiUrl(const FString& Path)
+{
+	FString BaseUrl = GetDefault<UGridlyGameSettings>()->ApiBaseUrl;
+	BaseUrl.RemoveFromEnd(TEXT("/"));
+	return BaseUrl + Path;
+}
+
+FHttpRequestRef FGridlyHttp::CreateRequest(const FString& Verb, const FString& Url, const FString& ApiKey)
+{
+	const FHttpRequestRef HttpRequest = FHttpModule::Get().CreateRequest();
+	HttpRequest->SetVerb(Verb);
+	HttpRequest->SetURL(Url);
+	HttpRequest->SetHeader(TEXT("Authorization"), FString::Printf(TEXT("ApiKey %s"), *ApiKey));
+
+	if (GetDefault<UGridlyGameSettings>()->bAcceptCompressedResponses)
+	{
+		HttpRequest->SetHeader(TEXT("Accept-Encoding"), TEXT("gzip"));
+	}
+
+	return HttpRequest;
+}
+
+void FGridlyHttp::SetContentAsString(const FHttpRequestRef& HttpRequest, const FString& Content)
+{
+	const FTCHARToUTF8 Converted(*Content, Content.Len());
+	TArray<uint8> Utf8Content(reinterpret_cast<const uint8*>(Converted.Get()), Converted.Length());
+
+	TArray<uint8> Compressed;
+	if (GetDefault<UGridlyGameSettings>()->bCompressRequestBodies && Utf8Content.Num() >= GridlyMinCompressedContentSize
+	    && Compress(Utf8Content, Compressed))
+	{
+		UE_LOG(LogGridly, Verbose, TEXT("Compressed request body from %d to %d bytes"), Utf8Content.Num(), Compressed.Num());
+		HttpRequest->SetHeader(TEXT("Content-Encoding"), TEXT("gzip"));
+		HttpRequest->SetContent(MoveTemp(Compressed));
+	}
+	else
+	{
+		HttpRequest->SetContent(MoveTemp(Utf8Content));
+	}
+}
+
+bool FGridlyHttp::GetContent(const FHttpResponsePtr& HttpResponsePtr, TArray<uint8>& OutContent)
+{
+	if (!HttpResponsePtr.IsValid())
+	{
+		return false;
+	}
+
+	// Checked by content rather than Content-Encoding, since some transports decode the body but keep the header
+
+	const TArray<uint8>& Content = HttpResponsePtr->GetContent();
+	if (IsGzip(Content))
+	{
+		return Decompress(Content, OutContent);
+	}
+
+	OutContent = Content;
+	return true;
+}
+
+FString FGridlyHttp::GetContentAsString(const FHttpResponsePtr& HttpResponsePtr)
+{
+	if (!HttpResponsePtr.IsValid())
+	{
+		return FString();
+	}
+
+	if (!IsGzip(HttpResponsePtr->GetContent()))
+	{
+		return HttpResponsePtr->GetContentAsString();
+	}
+
+	TArray<uint8> Content;
+	if (!Decompress(HttpResponsePtr->GetContent(), Content))
+	{
+		return FString();
+	}
+
+	const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Content.GetData()), Content.Num());
+	return FString(Converted.Length(), Converted.Get());
+}
+
+bool FGridlyHttp::GetContentAsUtf8(const FHttpResponsePtr& HttpResponsePtr, TArray<uint8>& OutBuffer,
+	FUtf8StringView& OutContent)
+{
+	OutContent.Reset();
+
+	if (!HttpResponsePtr.IsValid())
+	{
+		return false;
+	}
+
+	const TArray<uint8>* Content = &HttpResponsePtr->GetContent();
+	if (IsGzip(*Content))
+	{
+		if (!Decompress(*Content, OutBuffer))
+		{
+			return false;
+		}
+
+		Content = &OutBuffer;
+	}
+
+	OutContent = FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(Content->GetData()), Content->Num());
+
+	// Skip the byte order mark, which GetContentAsString drops as well
+	if (OutContent.Len() >= 3 && OutContent[0] == 0xEF && OutContent[1] == 0xBB && OutContent[2] == 0xBF)
+	{
+		OutContent.RightChopInline(3);
+	}
+
+	return true;
+}
+
+bool FGridlyHttp::IsGzip(const TArray<uint8>& Content)
+{
+	// Magic bytes followed by the deflate method, and room for the 10 byte header and 8 byte trailer
+	return Content.Num() >= 18 && Content[0] == 0x1F && Content[1] == 0x8B && Content[2] == 0x08;
+}
+
+bool FGridlyHttp::Compress(const TArray<uint8>& Content, TArray<uint8>& OutCompressed)
+{
+	int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Gzip, Content.Num());
+	OutCompressed.SetNumUninitialized(CompressedSize);
+
+	if (!FCompression::CompressMemory(NAME_Gzip, OutCompressed.GetData(), CompressedSize, Content.GetData(), Content.Num()))
+	{
+		OutCompressed.Reset();
+		return false;
+	}
+
+	OutCompressed.SetNum(CompressedSize);
+	return true;
+}
+
+bool FGridlyHttp::Decompress(const TArray<uint8>& Compressed, TArray<uint8>& OutContent)
+{
+	// The trailer ends with the uncompressed size, little endian
+
+	const int32 Num = Compressed.Num();
+	const uint32 Size = Compressed[Num - 4] | (Compressed[Num - 3] << 8) | (Compressed[Num - 2] << 16)
+	                    | (static_cast<uint32>(Compressed[Num - 1]) << 24);
+
+	if (Size > GridlyMaxDecompressedContentSize)
+	{
+		UE_LOG(LogGridly, Error, TEXT("Compressed response states an invalid size: %u"), Size);
+		return false;
+	}
+
+	OutContent.SetNumUninitialized(Size);
+	if (!FCompression::UncompressMemory(NAME_Gzip, OutContent.GetData(), Size, Compressed.GetData(), Num))
+	{
+		UE_LOG(LogGridly, Error, TEXT("Failed to decompress response of %d bytes"), Num);
+		OutContent.Reset();
+		return false;
+	}
+
+	return true;
+}
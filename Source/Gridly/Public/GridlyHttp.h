@@ -0,0 +1,39 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Containers/StringView.h"
+#include "Interfaces/IHttpRequest.h"
+
+/**
+ * Common setup for requests to the Gridly API. Builds URLs on the configured API base URL, and applies the gzip settings
+ * to request bodies and responses.
+ */
+class GRIDLY_API FGridlyHttp
+{
+public:
+	/** Full URL of an API path such as "/v1/views/xyz/records" */
+	static FString GetApiUrl(const FString& Path);
+
+	/** Creates a request with the API key set, advertising gzip responses when enabled */
+	static FHttpRequestRef CreateRequest(const FString& Verb, const FString& Url, const FString& ApiKey);
+
+	/** Sets the body as UTF-8, gzip-compressed when enabled and large enough to benefit from it */
+	static void SetContentAsString(const FHttpRequestRef& HttpRequest, const FString& Content);
+
+	/** Body of a response, decompressed if it is still gzip-encoded */
+	static bool GetContent(const FHttpResponsePtr& HttpResponsePtr, TArray<uint8>& OutContent);
+	static FString GetContentAsString(const FHttpResponsePtr& HttpResponsePtr);
+
+	/**
+	 * Body of a response as UTF-8, without widening it to TCHAR. The view points into the response, or into OutBuffer if the
+	 * body had to be decompressed, and is only valid as long as both are
+	 */
+	static bool GetContentAsUtf8(const FHttpResponsePtr& HttpResponsePtr, TArray<uint8>& OutBuffer, FUtf8StringView& OutContent);
+
+	static bool IsGzip(const TArray<uint8>& Content);
+	static bool Compress(const TArray<uint8>& Content, TArray<uint8>& OutCompressed);
+	static bool Decompress(const TArray<uint8>& Compressed, TArray<uint8>& OutContent);
+};
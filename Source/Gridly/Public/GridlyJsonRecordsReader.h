@@ -0,0 +1,407 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Pull reader for the JSON returned by the Gridly records endpoint. The payload is walked once without building a DOM, so
+ * callers only allocate the values they keep and skip everything else.
+ *
+ * Arrays and objects are walked with NextElement/NextField, which return false once the closing bracket is consumed. Any
+ * malformed input sets the error flag and makes every further call return false.
+ *
+ * Reads either TCHAR strings or the UTF-8 bytes of a response as they are. Multi-byte sequences never contain quotes or
+ * backslashes, so they are only converted when appended to the values being kept.
+ */
+template <typename CharType>
+class TGridlyJsonRecordsReader
+{
+public:
+	TGridlyJsonRecordsReader(const CharType* InData, int32 InLen);
+
+	/** Consumes the opening bracket of an array */
+	bool ReadArrayStart();
+
+	/** Consumes the opening brace of an object */
+	bool ReadObjectStart();
+
+	/** Returns true if the current array has another element to read */
+	bool NextElement();
+
+	/** Reads the name of the next field in the current object. Returns false at the end of the object */
+	bool NextField(FString& OutName);
+
+	/**
+	 * Reads a scalar value as text. Numbers are formatted the way FJsonObjectConverter converts them to strings, so 1.0 and 1e3
+	 * are read as 1 and 1000. Null, objects and arrays are skipped and read as an empty string
+	 */
+	bool ReadString(FString& OutValue);
+
+	/** Skips over the next value, including any nested objects and arrays */
+	bool SkipValue();
+
+	bool HasError() const { return bError; }
+
+private:
+	void SkipWhitespace();
+	bool Consume(ANSICHAR Char);
+	bool ReadQuotedString(FString* OutValue);
+	bool ReadLiteral(FString* OutValue);
+	bool ReadHexCodeUnit(uint32& OutCodeUnit);
+	bool SetError();
+
+private:
+	const CharType* Data;
+	int32 Len;
+	int32 Pos;
+	bool bError;
+};
+
+template <typename CharType>
+TGridlyJsonRecordsReader<CharType>::TGridlyJsonRecordsReader(const CharType* InData, int32 InLen) :
+	Data(InData),
+	Len(InData ? InLen : 0),
+	Pos(0),
+	bError(false)
+{
+}
+
+template <typename CharType>
+bool TGridlyJsonRecordsReader<CharType>::ReadArrayStart()
+{
+	SkipWhitespace();
+	return Consume('[') || SetError();
+}
+
+template <typename CharType>
+bool TGridlyJsonRecordsReader<CharType>::ReadObjectStart()
+{
+	SkipWhitespace();
+	return Consume('{') || SetError();
+}
+
+template <typename CharType>
+bool TGridlyJsonRecordsReader<CharType>::NextElement()
+{
+	SkipWhitespace();
+	if (bError || Pos >= Len)
+	{
+		return SetError();
+	}
+
+	if (Consume(']'))
+	{
+		return false;
+	}
+
+	Consume(',');
+	SkipWhitespace();
+	return Pos < Len || SetError();
+}
+
+template <typename CharType>
+bool TGridlyJsonRecordsReader<CharType>::NextField(FString& OutName)
+{
+	SkipWhitespace();
+	if (bError || Pos >= Len)
+	{
+		return SetError();
+	}
+
+	if (Consume('}'))
+	{
+		return false;
+	}
+
+	Consume(',');
+	SkipWhitespace();
+
+	OutName.Reset();
+	if (!Consume('"') || !ReadQuotedString(&OutName))
+	{
+		return SetError();
+	}
+
+	SkipWhitespace();
+	return Consume(':') || SetError();
+}
+
+template <typename CharType>
+bool TGridlyJsonRecordsReader<CharType>::ReadString(FString& OutValue)
+{
+	OutValue.Reset();
+
+	SkipWhitespace();
+	if (bError || Pos >= Len)
+	{
+		return SetError();
+	}
+
+	const CharType Char = Data[Pos];
+	if (Char == '"')
+	{
+		Pos++;
+		return ReadQuotedString(&OutValue);
+	}
+
+	if (Char == '{' || Char == '[')
+	{
+		return SkipValue();
+	}
+
+	if (!ReadLiteral(&OutValue))
+	{
+		return false;
+	}
+
+	if (OutValue == TEXT("null"))
+	{
+		OutValue.Reset();
+	}
+	else if (Char == '-' || (Char >= '0' && Char <= '9'))
+	{
+		OutValue = FString::SanitizeFloat(FCString::Atod(*OutValue), 0);
+	}
+
+	return true;
+}
+
+template <typename CharType>
+bool TGridlyJsonRecordsReader<CharType>::SkipValue()
+{
+	SkipWhitespace();
+	if (bError || Pos >= Len)
+	{
+		return SetError();
+	}
+
+	const CharType Char = Data[Pos];
+	if (Char == '"')
+	{
+		Pos++;
+		return ReadQuotedString(nullptr);
+	}
+
+	if (Char != '{' && Char != '[')
+	{
+		return ReadLiteral(nullptr);
+	}
+
+	// Nested containers only need their brackets balanced, strings are skipped so brackets inside them are ignored
+
+	int32 Depth = 0;
+	while (Pos < Len)
+	{
+		const CharType Current = Data[Pos++];
+		if (Current == '"')
+		{
+			if (!ReadQuotedString(nullptr))
+			{
+				return false;
+			}
+		}
+		else if (Current == '{' || Current == '[')
+		{
+			Depth++;
+		}
+		else if ((Current == '}' || Current == ']') && --Depth == 0)
+		{
+			return true;
+		}
+	}
+
+	return SetError();
+}
+
+template <typename CharType>
+void TGridlyJsonRecordsReader<CharType>::SkipWhitespace()
+{
+	while (Pos < Len && (Data[Pos] == ' ' || Data[Pos] == '\n' || Data[Pos] == '\r' || Data[Pos] == '\t'))
+	{
+		Pos++;
+	}
+}
+
+template <typename CharType>
+bool TGridlyJsonRecordsReader<CharType>::Consume(ANSICHAR Char)
+{
+	if (!bError && Pos < Len && Data[Pos] == Char)
+	{
+		Pos++;
+		return true;
+	}
+
+	return false;
+}
+
+template <typename CharType>
+bool TGridlyJsonRecordsReader<CharType>::ReadQuotedString(FString* OutValue)
+{
+	// Expects the opening quote to be consumed. Runs without escapes are appended in one go
+
+	int32 RunStart = Pos;
+	while (Pos < Len)
+	{
+		const CharType Char = Data[Pos];
+		if (Char != '"' && Char != '\\')
+		{
+			Pos++;
+			continue;
+		}
+
+		if (OutValue && Pos > RunStart)
+		{
+			OutValue->AppendChars(Data + RunStart, Pos - RunStart);
+		}
+
+		Pos++;
+
+		if (Char == '"')
+		{
+			return true;
+		}
+
+		if (Pos >= Len)
+		{
+			break;
+		}
+
+		const CharType Escape = Data[Pos++];
+		TCHAR Unescaped = 0;
+		switch (Escape)
+		{
+		case '"': Unescaped = TEXT('"'); break;
+		case '\\': Unescaped = TEXT('\\'); break;
+		case '/': Unescaped = TEXT('/'); break;
+		case 'b': Unescaped = TEXT('\b'); break;
+		case 'f': Unescaped = TEXT('\f'); break;
+		case 'n': Unescaped = TEXT('\n'); break;
+		case 'r': Unescaped = TEXT('\r'); break;
+		case 't': Unescaped = TEXT('\t'); break;
+		case 'u':
+			{
+				uint32 CodeUnit = 0;
+				if (!ReadHexCodeUnit(CodeUnit))
+				{
+					return false;
+				}
+
+				// Surrogate pairs are combined when TCHAR can hold the whole code point
+
+				uint32 LowCodeUnit = 0;
+				if (sizeof(TCHAR) == 4 && CodeUnit >= 0xD800 && CodeUnit <= 0xDBFF && Pos + 1 < Len && Data[Pos] == '\\'
+				    && Data[Pos + 1] == 'u')
+				{
+					Pos += 2;
+					if (!ReadHexCodeUnit(LowCodeUnit))
+					{
+						return false;
+					}
+
+					if (LowCodeUnit >= 0xDC00 && LowCodeUnit <= 0xDFFF)
+					{
+						CodeUnit = 0x10000 + ((CodeUnit - 0xD800) << 10) + (LowCodeUnit - 0xDC00);
+						LowCodeUnit = 0;
+					}
+				}
+
+				if (OutValue)
+				{
+					OutValue->AppendChar(static_cast<TCHAR>(CodeUnit));
+					if (LowCodeUnit != 0)
+					{
+						OutValue->AppendChar(static_cast<TCHAR>(LowCodeUnit));
+					}
+				}
+			}
+			break;
+		default:
+			return SetError();
+		}
+
+		if (OutValue && Unescaped != 0)
+		{
+			OutValue->AppendChar(Unescaped);
+		}
+
+		RunStart = Pos;
+	}
+
+	return SetError();
+}
+
+template <typename CharType>
+bool TGridlyJsonRecordsReader<CharType>::ReadLiteral(FString* OutValue)
+{
+	// Numbers, true, false and null
+
+	const int32 Start = Pos;
+	while (Pos < Len)
+	{
+		const CharType Char = Data[Pos];
+		if (Char == ',' || Char == '}' || Char == ']' || Char == ' ' || Char == '\n' || Char == '\r' || Char == '\t')
+		{
+			break;
+		}
+		Pos++;
+	}
+
+	if (Pos == Start)
+	{
+		return SetError();
+	}
+
+	if (OutValue)
+	{
+		OutValue->AppendChars(Data + Start, Pos - Start);
+	}
+
+	return true;
+}
+
+template <typename CharType>
+bool TGridlyJsonRecordsReader<CharType>::ReadHexCodeUnit(uint32& OutCodeUnit)
+{
+	if (Pos + 4 > Len)
+	{
+		return SetError();
+	}
+
+	OutCodeUnit = 0;
+	for (int32 i = 0; i < 4; i++)
+	{
+		const CharType Char = Data[Pos++];
+		uint32 Digit;
+		if (Char >= '0' && Char <= '9')
+		{
+			Digit = Char - '0';
+		}
+		else if (Char >= 'a' && Char <= 'f')
+		{
+			Digit = Char - 'a' + 10;
+		}
+		else if (Char >= 'A' && Char <= 'F')
+		{
+			Digit = Char - 'A' + 10;
+		}
+		else
+		{
+			return SetError();
+		}
+
+		OutCodeUnit = (OutCodeUnit << 4) | Digit;
+	}
+
+	return true;
+}
+
+template <typename CharType>
+bool TGridlyJsonRecordsReader<CharType>::SetError()
+{
+	bError = true;
+	return false;
+}
+
+using FGridlyJsonRecordsReader = TGridlyJsonRecordsReader<TCHAR>;
+using FGridlyUtf8JsonRecordsReader = TGridlyJsonRecordsReader<UTF8CHAR>;
@@ -2,21 +2,36 @@
 
 #include "GridlyLocalizedTextConverter.h"
 
+#include "Algo/Sort.h"
+#include "Containers/Queue.h"
 #include "Gridly.h"
-#include "GridlyCultureConverter.h"
+#include "GridlyColumnPlan.h"
 #include "GridlyDataTableImporterJSON.h"
 #include "GridlyGameSettings.h"
+#include "GridlyJsonRecordsReader.h"
+#include "GridlyPoWriter.h"
+#include "GridlySnapshot.h"
+#include "GridlyTextSegments.h"
+#include "HAL/FileManager.h"
+#include "Hash/xxhash.h"
 #include "Internationalization/PolyglotTextData.h"
 #include "Misc/FileHelper.h"
+#include "Tasks/Task.h"
 
 bool FGridlyLocalizedTextConverter::TableRowsToPolyglotTextDatas(const TArray<FGridlyTableRow>& TableRows,
 	TMap<FString, FPolyglotTextData>& OutPolyglotTextDatas)
 {
-	UGridlyGameSettings* GameSettings = GetMutableDefault<UGridlyGameSettings>();
-	const TArray<FString> TargetCultures = FGridlyCultureConverter::GetTargetCultures();
+	FGridlyColumnPlan ColumnPlan;
+	return TableRowsToPolyglotTextDatas(TableRows, ColumnPlan, OutPolyglotTextDatas);
+}
+
+bool FGridlyLocalizedTextConverter::TableRowsToPolyglotTextDatas(const TArray<FGridlyTableRow>& TableRows,
+	FGridlyColumnPlan& ColumnPlan, TMap<FString, FPolyglotTextData>& OutPolyglotTextDatas)
+{
+	using EColumnRole = FGridlyColumnPlan::EColumnRole;
 
-	const bool bUseCombinedNamespaceKey = GameSettings->bUseCombinedNamespaceId;
-	const bool bUsePathAsNamespace = !bUseCombinedNamespaceKey && GameSettings->NamespaceColumnId == "path";
+	const bool bUseCombinedNamespaceKey = ColumnPlan.UsesCombinedNamespaceKey();
+	const bool bUsePathAsNamespace = ColumnPlan.UsesPathAsNamespace();
 
 	for (int i = 0; i < TableRows.Num(); i++)
 	{
@@ -32,35 +47,22 @@ bool FGridlyLocalizedTextConverter::TableRowsToPolyglotTextDatas(const TArray<FG
 		for (int j = 0; j < TableRows[i].Cells.Num(); j++)
 		{
 			const FGridlyTableCell& GridlyTableCell = TableRows[i].Cells[j];
+			const FGridlyColumnPlan::FColumn& Column = ColumnPlan.FindOrResolve(GridlyTableCell.ColumnId, j);
 
-			// If special columns
-
-			if (!bUsePathAsNamespace && GridlyTableCell.ColumnId == GameSettings->NamespaceColumnId)
+			switch (Column.Role)
 			{
+			case EColumnRole::Namespace:
 				Namespace = GridlyTableCell.Value;
-				continue;
-			}
-
-			// If language column
-
-			if (GridlyTableCell.ColumnId.StartsWith(GameSettings->SourceLanguageColumnIdPrefix))
-			{
-				const FString GridlyCulture = GridlyTableCell.ColumnId.RightChop(GameSettings->SourceLanguageColumnIdPrefix.Len());
-				FString Culture;
-				if (FGridlyCultureConverter::ConvertFromGridly(TargetCultures, GridlyCulture, Culture))
-				{
-					SourceCulture = Culture;
-					SourceText = GridlyTableCell.Value;
-				}
-			}
-			else if (GridlyTableCell.ColumnId.StartsWith(GameSettings->TargetLanguageColumnIdPrefix))
-			{
-				const FString GridlyCulture = GridlyTableCell.ColumnId.RightChop(GameSettings->TargetLanguageColumnIdPrefix.Len());
-				FString Culture;
-				if (FGridlyCultureConverter::ConvertFromGridly(TargetCultures, GridlyCulture, Culture))
-				{
-					Translations.Add(Culture, GridlyTableCell.Value);
-				}
+				break;
+			case EColumnRole::Source:
+				SourceCulture = Column.Culture;
+				SourceText = GridlyTableCell.Value;
+				break;
+			case EColumnRole::Target:
+				Translations.Add(Column.Culture, GridlyTableCell.Value);
+				break;
+			default:
+				break;
 			}
 		}
 
@@ -100,74 +102,571 @@ bool FGridlyLocalizedTextConverter::TableRowsToPolyglotTextDatas(const TArray<FG
 	return OutPolyglotTextDatas.Num() > 0;
 }
 
-// Taken from "Engine\Source\Developer\Localization\Private\PortableObjectPipeline.cpp"
-FString ConditionArchiveStrForPO(const FString& InStr)
+namespace GridlyLocalizedTextConverter
 {
-	FString Result = InStr;
-	Result.ReplaceInline(TEXT("\\"), TEXT("\\\\"), ESearchCase::CaseSensitive);
-	Result.ReplaceInline(TEXT("\""), TEXT("\\\""), ESearchCase::CaseSensitive);
-	Result.ReplaceInline(TEXT("\r"), TEXT("\\r"), ESearchCase::CaseSensitive);
-	Result.ReplaceInline(TEXT("\n"), TEXT("\\n"), ESearchCase::CaseSensitive);
-	Result.ReplaceInline(TEXT("\t"), TEXT("\\t"), ESearchCase::CaseSensitive);
-	return Result;
+	template <typename CharType>
+	bool JsonToPolyglotTextDatas(const CharType* Json, int32 JsonLen, FGridlyColumnPlan& ColumnPlan,
+		TMap<FString, FPolyglotTextData>& OutPolyglotTextDatas, int32& OutNumRecords)
+	{
+		using EColumnRole = FGridlyColumnPlan::EColumnRole;
+
+		OutNumRecords = 0;
+
+		const bool bUseCombinedNamespaceKey = ColumnPlan.UsesCombinedNamespaceKey();
+		const bool bUsePathAsNamespace = ColumnPlan.UsesPathAsNamespace();
+
+		// Reused between records and cells so values are only allocated when they are kept
+
+		FString FieldName;
+		FString CellFieldName;
+		FString ColumnId;
+		FString Value;
+
+		FString Id;
+		FString Path;
+		FString Namespace;
+		FString SourceCulture;
+		FString SourceText;
+		TArray<TPair<FString, FString>> Translations;
+
+		TGridlyJsonRecordsReader<CharType> Reader(Json, JsonLen);
+		if (!Reader.ReadArrayStart())
+		{
+			return false;
+		}
+
+		while (Reader.NextElement())
+		{
+			if (!Reader.ReadObjectStart())
+			{
+				return false;
+			}
+
+			Id.Reset();
+			Path.Reset();
+			Namespace.Reset();
+			SourceCulture.Reset();
+			SourceText.Reset();
+			Translations.Reset();
+
+			while (Reader.NextField(FieldName))
+			{
+				if (FieldName == TEXT("id"))
+				{
+					Reader.ReadString(Id);
+				}
+				else if (FieldName == TEXT("path"))
+				{
+					Reader.ReadString(Path);
+				}
+				else if (FieldName == TEXT("cells") && Reader.ReadArrayStart())
+				{
+					int32 CellIndex = 0;
+					while (Reader.NextElement() && Reader.ReadObjectStart())
+					{
+						const FGridlyColumnPlan::FColumn* ColumnRole = nullptr;
+						bool bHasValue = false;
+
+						while (Reader.NextField(CellFieldName))
+						{
+							if (CellFieldName == TEXT("columnId"))
+							{
+								Reader.ReadString(ColumnId);
+								ColumnRole = &ColumnPlan.FindOrResolve(ColumnId, CellIndex);
+							}
+							else if (CellFieldName == TEXT("value") && (!ColumnRole || ColumnRole->Role != EColumnRole::Ignored))
+							{
+								// The value is only skipped once the column is known to be unmapped
+								Reader.ReadString(Value);
+								bHasValue = true;
+							}
+							else
+							{
+								Reader.SkipValue();
+							}
+						}
+
+						CellIndex++;
+
+						if (!ColumnRole || !bHasValue)
+						{
+							continue;
+						}
+
+						switch (ColumnRole->Role)
+						{
+						case EColumnRole::Namespace:
+							Namespace = Value;
+							break;
+						case EColumnRole::Source:
+							SourceCulture = ColumnRole->Culture;
+							SourceText = Value;
+							break;
+						case EColumnRole::Target:
+							Translations.Emplace(ColumnRole->Culture, Value);
+							break;
+						default:
+							break;
+						}
+					}
+				}
+				else
+				{
+					Reader.SkipValue();
+				}
+			}
+
+			if (Reader.HasError())
+			{
+				break;
+			}
+
+			OutNumRecords++;
+			UE_LOG(LogGridly, Verbose, TEXT("Row %d: %s (%s)"), OutNumRecords - 1, *Id, *Path);
+
+			// Namespace / key fixes
+
+			FString Key = Id;
+			if (bUsePathAsNamespace)
+			{
+				Namespace = Path;
+			}
+
+			if (bUseCombinedNamespaceKey)
+			{
+				FString NewKey;
+				if (Key.Split(",", &Namespace, &NewKey))
+				{
+					Key = NewKey;
+				}
+			}
+
+			Namespace.ReplaceInline(TEXT(" "), TEXT(""));
+
+			if (SourceText.IsEmpty() || SourceCulture.IsEmpty())
+			{
+				UE_LOG(LogGridly, Warning, TEXT("Could not find native culture/source string in imported text with key: %s,%s"),
+					*Namespace, *Key);
+			}
+
+			FPolyglotTextData PolyglotTextData(ELocalizedTextSourceCategory::Game, Namespace, Key, SourceText, SourceCulture);
+
+			for (const TPair<FString, FString>& Pair : Translations)
+			{
+				if (!Pair.Value.IsEmpty())
+				{
+					PolyglotTextData.AddLocalizedString(Pair.Key, Pair.Value);
+				}
+			}
+
+			OutPolyglotTextDatas.Add(Id, MoveTemp(PolyglotTextData));
+		}
+
+		if (Reader.HasError())
+		{
+			UE_LOG(LogGridly, Error, TEXT("Malformed records payload after %d records"), OutNumRecords);
+			return false;
+		}
+
+		return OutPolyglotTextDatas.Num() > 0;
+	}
+}
+
+bool FGridlyLocalizedTextConverter::JsonToPolyglotTextDatas(FStringView Json, FGridlyColumnPlan& ColumnPlan,
+	TMap<FString, FPolyglotTextData>& OutPolyglotTextDatas, int32& OutNumRecords)
+{
+	return GridlyLocalizedTextConverter::JsonToPolyglotTextDatas(Json.GetData(), Json.Len(), ColumnPlan, OutPolyglotTextDatas,
+		OutNumRecords);
+}
+
+bool FGridlyLocalizedTextConverter::JsonToPolyglotTextDatas(FUtf8StringView Json, FGridlyColumnPlan& ColumnPlan,
+	TMap<FString, FPolyglotTextData>& OutPolyglotTextDatas, int32& OutNumRecords)
+{
+	return GridlyLocalizedTextConverter::JsonToPolyglotTextDatas(Json.GetData(), Json.Len(), ColumnPlan, OutPolyglotTextDatas,
+		OutNumRecords);
+}
+
+void FGridlyLocalizedTextConverter::SerializePolyglotTextData(FArchive& Ar, FPolyglotTextData& PolyglotTextData)
+{
+	uint8 Category = static_cast<uint8>(PolyglotTextData.GetCategory());
+	FString Namespace = PolyglotTextData.GetNamespace();
+	FString Key = PolyglotTextData.GetKey();
+	FString NativeString = PolyglotTextData.GetNativeString();
+	FString NativeCulture = PolyglotTextData.GetNativeCulture();
+	TArray<FString> Cultures = PolyglotTextData.GetLocalizedCultures();
+
+	Ar << Category << Namespace << Key << NativeString << NativeCulture << Cultures;
+
+	if (Ar.IsLoading())
+	{
+		PolyglotTextData = FPolyglotTextData(static_cast<ELocalizedTextSourceCategory>(Category), Namespace, Key, NativeString,
+			NativeCulture);
+
+		for (const FString& Culture : Cultures)
+		{
+			FString LocalizedString;
+			Ar << LocalizedString;
+			PolyglotTextData.AddLocalizedString(Culture, LocalizedString);
+		}
+	}
+	else
+	{
+		for (const FString& Culture : Cultures)
+		{
+			FString LocalizedString;
+			PolyglotTextData.GetLocalizedString(Culture, LocalizedString);
+			Ar << LocalizedString;
+		}
+	}
+}
+
+uint32 FGridlyLocalizedTextConverter::HashPolyglotTextData(const FPolyglotTextData& PolyglotTextData)
+{
+	uint32 Hash = FGridlySnapshot::HashString(PolyglotTextData.GetNativeString());
+	Hash = FGridlySnapshot::HashString(PolyglotTextData.GetNativeCulture(), Hash);
+
+	TArray<FString> Cultures = PolyglotTextData.GetLocalizedCultures();
+	Cultures.Sort();
+
+	for (const FString& Culture : Cultures)
+	{
+		FString LocalizedString;
+		PolyglotTextData.GetLocalizedString(Culture, LocalizedString);
+		Hash = FGridlySnapshot::HashString(Culture, Hash);
+		Hash = FGridlySnapshot::HashString(LocalizedString, Hash);
+	}
+
+	return Hash;
+}
+
+namespace GridlyLocalizedTextConverter
+{
+	// Bumped whenever the written format changes, so files written by an older writer are never considered unchanged
+	static constexpr uint64 PoFileHashVersion = 1;
+
+	TArray<const FPolyglotTextData*> SortByNamespaceAndKey(const TArray<FPolyglotTextData>& PolyglotTextDatas)
+	{
+		// Pages arrive in any order and texts are collected in maps, so entries are sorted for the files to be stable
+
+		TArray<const FPolyglotTextData*> SortedPolyglotTextDatas;
+		SortedPolyglotTextDatas.Reserve(PolyglotTextDatas.Num());
+		for (const FPolyglotTextData& PolyglotTextData : PolyglotTextDatas)
+		{
+			SortedPolyglotTextDatas.Add(&PolyglotTextData);
+		}
+
+		Algo::Sort(SortedPolyglotTextDatas, [](const FPolyglotTextData* A, const FPolyglotTextData* B)
+		{
+			const int32 Result = A->GetNamespace().Compare(B->GetNamespace(), ESearchCase::CaseSensitive);
+			return Result != 0 ? Result < 0 : A->GetKey().Compare(B->GetKey(), ESearchCase::CaseSensitive) < 0;
+		});
+
+		return SortedPolyglotTextDatas;
+	}
+
+	void HashField(FXxHash64Builder& Builder, const FString& Field)
+	{
+		// The length is hashed too, so moving text from one field to the next changes the hash
+
+		const int32 Len = Field.Len();
+		Builder.Update(&Len, sizeof(Len));
+		Builder.Update(*Field, Len * sizeof(TCHAR));
+	}
+
+	uint64 HashPoFile(const TArray<const FPolyglotTextData*>& SortedPolyglotTextDatas, const FString& TargetCulture)
+	{
+		FXxHash64Builder Builder;
+		Builder.Update(&PoFileHashVersion, sizeof(PoFileHashVersion));
+
+		FString TargetString;
+		for (const FPolyglotTextData* PolyglotTextData : SortedPolyglotTextDatas)
+		{
+			if (!PolyglotTextData->GetLocalizedString(TargetCulture, TargetString))
+			{
+				TargetString.Reset();
+			}
+
+			HashField(Builder, PolyglotTextData->GetNamespace());
+			HashField(Builder, PolyglotTextData->GetKey());
+			HashField(Builder, PolyglotTextData->GetNativeString());
+			HashField(Builder, TargetString);
+		}
+
+		return Builder.Finalize().Hash;
+	}
+
+	FString GetPoFileHashPath(const FString& Path)
+	{
+		return Path + TEXT(".hash");
+	}
+
+	bool IsPoFileUnchanged(const FString& Path, uint64 Hash)
+	{
+		FString StoredHash;
+		return IFileManager::Get().FileSize(*Path) > 0 && FFileHelper::LoadFileToString(StoredHash, *GetPoFileHashPath(Path))
+		       && StoredHash.TrimStartAndEnd() == FString::Printf(TEXT("%016llx"), Hash);
+	}
+
+	FString GetPendingPoFileHashPath(const FString& Path)
+	{
+		return Path + TEXT(".hash.pending");
+	}
+
+	void DeletePoFileHashes(const FString& Path)
+	{
+		IFileManager::Get().Delete(*GetPoFileHashPath(Path), false, false, true);
+		IFileManager::Get().Delete(*GetPendingPoFileHashPath(Path), false, false, true);
+	}
+
+	void StorePendingPoFileHash(const FString& Path, uint64 Hash)
+	{
+		if (!FFileHelper::SaveStringToFile(FString::Printf(TEXT("%016llx"), Hash), *GetPendingPoFileHashPath(Path)))
+		{
+			UE_LOG(LogGridly, Warning, TEXT("Unable to store the content hash of .po file: %s"), *Path);
+		}
+	}
+
+	bool WritePoFile(const TArray<const FPolyglotTextData*>& SortedPolyglotTextDatas, const FString& TargetCulture,
+		const FString& Path)
+	{
+		const TUniquePtr<FArchive> Archive(IFileManager::Get().CreateFileWriter(*Path));
+		if (!Archive)
+		{
+			UE_LOG(LogGridly, Error, TEXT("Failed to export .po file to path: %s"), *Path);
+			return false;
+		}
+
+		// Entries without a translation are still written, with an empty msgstr
+
+		FGridlyPoWriter PoWriter(*Archive);
+		PoWriter.WriteByteOrderMark();
+
+		FString TargetString;
+		for (const FPolyglotTextData* PolyglotTextData : SortedPolyglotTextDatas)
+		{
+			if (!PolyglotTextData->GetLocalizedString(TargetCulture, TargetString))
+			{
+				TargetString.Reset();
+			}
+
+			PoWriter.WriteEntry(PolyglotTextData->GetNamespace(), PolyglotTextData->GetKey(), PolyglotTextData->GetNativeString(),
+				TargetString);
+		}
+
+		if (PoWriter.Flush() && Archive->Close())
+		{
+			UE_LOG(LogGridly, Log, TEXT("Exported .po file (%d lines): %s"), PoWriter.GetNumLines(), *Path);
+			return PoWriter.GetNumLines() > 0;
+		}
+		else
+		{
+			UE_LOG(LogGridly, Error, TEXT("Failed to export .po file to path: %s"), *Path);
+			return false;
+		}
+	}
 }
 
 bool FGridlyLocalizedTextConverter::WritePoFile(const TArray<FPolyglotTextData>& PolyglotTextDatas, const FString& TargetCulture,
 	const FString& Path)
 {
-	TArray<FString> Lines;
-	int numOfLines = 0;
-	TArray<TCHAR> CharsToReplace = { TEXT('\n'), TEXT('\r'), TEXT('\t'), TEXT('"'), TEXT('\\') };
+	return GridlyLocalizedTextConverter::WritePoFile(GridlyLocalizedTextConverter::SortByNamespaceAndKey(PolyglotTextDatas),
+		TargetCulture, Path);
+}
 
-	for (int i = 0; i < PolyglotTextDatas.Num(); i++)
+bool FGridlyLocalizedTextConverter::WritePoFiles(const TArray<FPolyglotTextData>& PolyglotTextDatas,
+	const TArray<FGridlyPoFile>& PoFiles, bool bSkipUnchanged, const FGridlyPoFileWrittenDelegate& OnPoFileWritten)
+{
+	using namespace GridlyLocalizedTextConverter;
+
+	// Each culture only reads the shared texts, so the files are written independently
+
+	const TArray<const FPolyglotTextData*> SortedPolyglotTextDatas = SortByNamespaceAndKey(PolyglotTextDatas);
+
+	struct FWrittenPoFile
 	{
-		FString TargetString;
+		int32 Index;
+		bool bSuccess;
+		bool bChanged;
+	};
 
-		if (PolyglotTextDatas[i].GetLocalizedString(TargetCulture, TargetString))
+	TQueue<FWrittenPoFile, EQueueMode::Mpsc> WrittenPoFiles;
+	TArray<UE::Tasks::FTask> Tasks;
+	Tasks.Reserve(PoFiles.Num());
+
+	for (int32 i = 0; i < PoFiles.Num(); i++)
+	{
+		Tasks.Add(UE::Tasks::Launch(UE_SOURCE_LOCATION, [&SortedPolyglotTextDatas, &PoFiles, &WrittenPoFiles, bSkipUnchanged, i]()
 		{
-			Lines.Add(FString::Printf(TEXT("msgctxt \"%s,%s\""), *PolyglotTextDatas[i].GetNamespace(),
-				*PolyglotTextDatas[i].GetKey()));
+			const FGridlyPoFile& PoFile = PoFiles[i];
+			const uint64 Hash = HashPoFile(SortedPolyglotTextDatas, PoFile.Culture);
 
-			
-			FString NativeString = PolyglotTextDatas[i].GetNativeString().ReplaceCharWithEscapedChar(&CharsToReplace);
-			Lines.Add(FString::Printf(TEXT("msgid \"%s\""), *NativeString));
+			if (bSkipUnchanged && IsPoFileUnchanged(PoFile.Path, Hash))
+			{
+				UE_LOG(LogGridly, Log, TEXT("Skipped unchanged .po file: %s"), *PoFile.Path);
+				WrittenPoFiles.Enqueue(FWrittenPoFile{i, true, false});
+				return;
+			}
+
+			// The stored hash is removed first, so a failed write is never mistaken for an unchanged file. The new hash only
+			// counts once the file is imported, see CommitPoFileHash
 
-			TargetString = ConditionArchiveStrForPO(TargetString);
-			//TargetString.ReplaceCharWithEscapedChar(&CharsToReplace);
-			Lines.Add(FString::Printf(TEXT("msgstr \"%s\""), *TargetString));
+			DeletePoFileHashes(PoFile.Path);
 
-			Lines.Add(TEXT(""));
-		}		
-		else {
-			Lines.Add(FString::Printf(TEXT("msgctxt \"%s,%s\""), *PolyglotTextDatas[i].GetNamespace(),
-				*PolyglotTextDatas[i].GetKey()));
+			const bool bSuccess = WritePoFile(SortedPolyglotTextDatas, PoFile.Culture, PoFile.Path);
+			if (bSuccess)
+			{
+				StorePendingPoFileHash(PoFile.Path, Hash);
+			}
 
+			WrittenPoFiles.Enqueue(FWrittenPoFile{i, bSuccess, true});
+		}));
+	}
 
-			FString NativeString = PolyglotTextDatas[i].GetNativeString().ReplaceCharWithEscapedChar(&CharsToReplace);
-			Lines.Add(FString::Printf(TEXT("msgid \"%s\""), *NativeString));
+	// Completion is reported from this thread while the remaining files are still being written
 
-			TargetString = TEXT("");
-			TargetString = TargetString.ReplaceCharWithEscapedChar(&CharsToReplace);
-			Lines.Add(FString::Printf(TEXT("msgstr \"%s\""), *TargetString));
+	int32 NumWritten = 0;
+	bool bAllSucceeded = true;
 
-			Lines.Add(TEXT(""));
+	auto ReportWrittenPoFiles = [&]()
+	{
+		FWrittenPoFile WrittenPoFile;
+		while (WrittenPoFiles.Dequeue(WrittenPoFile))
+		{
+			NumWritten++;
+			bAllSucceeded &= WrittenPoFile.bSuccess;
+			OnPoFileWritten.ExecuteIfBound(WrittenPoFile.Index, WrittenPoFile.bSuccess, WrittenPoFile.bChanged);
 		}
-		
+	};
+
+	while (!UE::Tasks::Wait(Tasks, FTimespan::FromMilliseconds(10)))
+	{
+		ReportWrittenPoFiles();
 	}
 
-	if (FFileHelper::SaveStringArrayToFile(Lines, *Path))
+	ReportWrittenPoFiles();
+	check(NumWritten == PoFiles.Num());
+
+	return bAllSucceeded;
+}
+
+bool FGridlyLocalizedTextConverter::WritePoFiles(const FGridlyTextSegments& TextSegments, const TArray<FGridlyPoFile>& PoFiles,
+	bool bSkipUnchanged, const FGridlyPoFileWrittenDelegate& OnPoFileWritten)
+{
+	using namespace GridlyLocalizedTextConverter;
+
+	// Every file is written from the same pass, with its hash built along the way like HashPoFile does
+
+	struct FPoFileWriter
 	{
-		UE_LOG(LogGridly, Log, TEXT("Exported .po file (%d lines): %s"), Lines.Num(), *Path);
-		if (Lines.Num() > 0) {
-			return true;
+		FString TempPath;
+		TUniquePtr<FArchive> Archive;
+		TUniquePtr<FGridlyPoWriter> PoWriter;
+		FXxHash64Builder HashBuilder;
+	};
+
+	TArray<FPoFileWriter> Writers;
+	Writers.SetNum(PoFiles.Num());
+
+	for (int32 i = 0; i < PoFiles.Num(); i++)
+	{
+		FPoFileWriter& Writer = Writers[i];
+		Writer.TempPath = PoFiles[i].Path + TEXT(".tmp");
+		Writer.Archive.Reset(IFileManager::Get().CreateFileWriter(*Writer.TempPath));
+		if (Writer.Archive)
+		{
+			Writer.PoWriter = MakeUnique<FGridlyPoWriter>(*Writer.Archive);
+			Writer.PoWriter->WriteByteOrderMark();
 		}
-		else {
-			return false;
+		else
+		{
+			UE_LOG(LogGridly, Error, TEXT("Failed to export .po file to path: %s"), *PoFiles[i].Path);
 		}
+
+		Writer.HashBuilder.Update(&PoFileHashVersion, sizeof(PoFileHashVersion));
 	}
-	else
+
+	FString TargetString;
+	const bool bReadSegments = TextSegments.ForEachSorted([&PoFiles, &Writers, &TargetString](const FPolyglotTextData& PolyglotTextData)
+	{
+		for (int32 i = 0; i < Writers.Num(); i++)
+		{
+			FPoFileWriter& Writer = Writers[i];
+			if (!Writer.PoWriter)
+			{
+				continue;
+			}
+
+			if (!PolyglotTextData.GetLocalizedString(PoFiles[i].Culture, TargetString))
+			{
+				TargetString.Reset();
+			}
+
+			HashField(Writer.HashBuilder, PolyglotTextData.GetNamespace());
+			HashField(Writer.HashBuilder, PolyglotTextData.GetKey());
+			HashField(Writer.HashBuilder, PolyglotTextData.GetNativeString());
+			HashField(Writer.HashBuilder, TargetString);
+
+			Writer.PoWriter->WriteEntry(PolyglotTextData.GetNamespace(), PolyglotTextData.GetKey(),
+				PolyglotTextData.GetNativeString(), TargetString);
+		}
+	});
+
+	bool bAllSucceeded = true;
+
+	for (int32 i = 0; i < PoFiles.Num(); i++)
+	{
+		FPoFileWriter& Writer = Writers[i];
+		const FGridlyPoFile& PoFile = PoFiles[i];
+
+		bool bSuccess = bReadSegments && Writer.PoWriter && Writer.PoWriter->Flush() && Writer.Archive->Close()
+		                && Writer.PoWriter->GetNumLines() > 0;
+		const int32 NumLines = Writer.PoWriter ? Writer.PoWriter->GetNumLines() : 0;
+		Writer.PoWriter.Reset();
+		Writer.Archive.Reset();
+
+		bool bChanged = true;
+		const uint64 Hash = Writer.HashBuilder.Finalize().Hash;
+
+		if (bSuccess && bSkipUnchanged && IsPoFileUnchanged(PoFile.Path, Hash))
+		{
+			UE_LOG(LogGridly, Log, TEXT("Skipped unchanged .po file: %s"), *PoFile.Path);
+			IFileManager::Get().Delete(*Writer.TempPath, false, false, true);
+			bChanged = false;
+		}
+		else if (bSuccess)
+		{
+			// The stored hash is removed first, so a failed move is never mistaken for an unchanged file
+
+			DeletePoFileHashes(PoFile.Path);
+			bSuccess = IFileManager::Get().Move(*PoFile.Path, *Writer.TempPath, true, true);
+		}
+
+		if (bSuccess && bChanged)
+		{
+			StorePendingPoFileHash(PoFile.Path, Hash);
+			UE_LOG(LogGridly, Log, TEXT("Exported .po file (%d lines): %s"), NumLines, *PoFile.Path);
+		}
+		else if (!bSuccess)
+		{
+			IFileManager::Get().Delete(*Writer.TempPath, false, false, true);
+			UE_LOG(LogGridly, Error, TEXT("Failed to export .po file to path: %s"), *PoFile.Path);
+		}
+
+		bAllSucceeded &= bSuccess;
+		OnPoFileWritten.ExecuteIfBound(i, bSuccess, bChanged);
+	}
+
+	return bAllSucceeded;
+}
+
+void FGridlyLocalizedTextConverter::CommitPoFileHash(const FString& Path)
+{
+	using namespace GridlyLocalizedTextConverter;
+
+	const FString PendingHashPath = GetPendingPoFileHashPath(Path);
+	if (IFileManager::Get().FileExists(*PendingHashPath)
+	    && !IFileManager::Get().Move(*GetPoFileHashPath(Path), *PendingHashPath, true, true, false, true))
 	{
-		UE_LOG(LogGridly, Error, TEXT("Failed to export .po file to path: %s"), *Path);
-		return false;
-	}	
-}
\ No newline at end of file
+		UE_LOG(LogGridly, Warning, TEXT("Unable to store the content hash of .po file: %s"), *Path);
+	}
+}
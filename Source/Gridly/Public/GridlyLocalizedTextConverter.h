@@ -4,12 +4,69 @@
 
 #include "CoreMinimal.h"
 
+#include "Containers/StringView.h"
 #include "GridlyTableRow.h"
 
+class FGridlyColumnPlan;
+class FGridlyTextSegments;
+
+/** A .po file to write for one culture */
+struct GRIDLY_API FGridlyPoFile
+{
+	FString Culture;
+	FString Path;
+};
+
+/**
+ * Called on the calling thread as each .po file is flushed, with its index in the requested files. bChanged is false when
+ * the file was skipped because its contents were the same as the last time it was written
+ */
+DECLARE_DELEGATE_ThreeParams(FGridlyPoFileWrittenDelegate, int32 /*Index*/, bool /*bSuccess*/, bool /*bChanged*/);
+
 class GRIDLY_API FGridlyLocalizedTextConverter
 {
 public:
 	static bool TableRowsToPolyglotTextDatas(const TArray<FGridlyTableRow>& TableRows,
 		TMap<FString, FPolyglotTextData>& OutPolyglotTextDatas);
+
+	/** Converts rows with the column roles of their view, which are resolved once and shared by every page of the view */
+	static bool TableRowsToPolyglotTextDatas(const TArray<FGridlyTableRow>& TableRows, FGridlyColumnPlan& ColumnPlan,
+		TMap<FString, FPolyglotTextData>& OutPolyglotTextDatas);
+
+	/** Decodes a page of records straight from the JSON payload, skipping columns that do not map to a culture or namespace */
+	static bool JsonToPolyglotTextDatas(FStringView Json, FGridlyColumnPlan& ColumnPlan,
+		TMap<FString, FPolyglotTextData>& OutPolyglotTextDatas, int32& OutNumRecords);
+
+	/** Same as above, reading the UTF-8 body of a response without converting it first */
+	static bool JsonToPolyglotTextDatas(FUtf8StringView Json, FGridlyColumnPlan& ColumnPlan,
+		TMap<FString, FPolyglotTextData>& OutPolyglotTextDatas, int32& OutNumRecords);
+
+	/** Compact binary form of a text, used by view snapshots */
+	static void SerializePolyglotTextData(FArchive& Ar, FPolyglotTextData& PolyglotTextData);
+	static uint32 HashPolyglotTextData(const FPolyglotTextData& PolyglotTextData);
+
+	/** Writes the entries sorted by namespace and key, so the same texts always produce the same file */
 	static bool WritePoFile(const TArray<FPolyglotTextData>& PolyglotTextDatas, const FString& TargetCulture, const FString& Path);
+
+	/**
+	 * Writes the .po files of all cultures concurrently on worker threads, and returns once every file is flushed. The
+	 * content hash of each written file is kept pending next to it until CommitPoFileHash, and with bSkipUnchanged a file
+	 * whose committed hash matches is left untouched
+	 */
+	static bool WritePoFiles(const TArray<FPolyglotTextData>& PolyglotTextDatas, const TArray<FGridlyPoFile>& PoFiles,
+		bool bSkipUnchanged, const FGridlyPoFileWrittenDelegate& OnPoFileWritten = FGridlyPoFileWrittenDelegate());
+
+	/**
+	 * Writes the .po files of all cultures in a single pass over the segments, so memory use does not grow with the number of
+	 * texts. Each file is written to a temporary file first, which only replaces it if its content hash changed or
+	 * bSkipUnchanged is unset
+	 */
+	static bool WritePoFiles(const FGridlyTextSegments& TextSegments, const TArray<FGridlyPoFile>& PoFiles, bool bSkipUnchanged,
+		const FGridlyPoFileWrittenDelegate& OnPoFileWritten = FGridlyPoFileWrittenDelegate());
+
+	/**
+	 * Stores the pending content hash of a written .po file as its .hash, once the file has been imported. Until then the
+	 * file is never considered unchanged, so a failed or interrupted import is done again
+	 */
+	static void CommitPoFileHash(const FString& Path);
 };
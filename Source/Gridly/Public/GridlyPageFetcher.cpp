@@ -0,0 +1,684 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#include "GridlyPageFetcher.h"
+
+#include "Gridly.h"
+#include "GridlyHttp.h"
+#include "GridlyRateLimiter.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Tasks/Task.h"
+
+FGridlyPageFetcher::FGridlyPageFetcher(const TArray<FString>& InViewIds, const FString& InApiKey, int32 InLimit,
+	int32 InMaxConcurrentRequests) :
+	ViewIds(InViewIds),
+	ApiKey(InApiKey),
+	Limit(FMath::Max(1, InLimit)),
+	MaxConcurrentRequests(FMath::Max(1, InMaxConcurrentRequests)),
+	MaxPageRetries(0),
+	CurrentViewIdIndex(0),
+	ViewTotalCount(INDEX_NONE),
+	NextRequestOffset(0),
+	NextCommitOffset(0),
+	TotalCount(0),
+	NumRetryingPages(0),
+	NumDecodingPages(0),
+	Generation(0),
+	bFinished(false),
+	SnapshotSchemaHash(0),
+	CheckpointSchemaHash(0),
+	ResumedTotalCount(INDEX_NONE)
+{
+}
+
+void FGridlyPageFetcher::EnableSnapshots(const FString& Kind, uint32 SchemaHash, const FTimespan& MaxAge)
+{
+	SnapshotKind = Kind;
+	SnapshotSchemaHash = SchemaHash;
+	SnapshotMaxAge = MaxAge;
+}
+
+void FGridlyPageFetcher::EnableCheckpoints(const FString& Kind, uint32 SchemaHash, const FTimespan& MaxAge)
+{
+	CheckpointKind = Kind;
+	CheckpointSchemaHash = SchemaHash;
+	CheckpointMaxAge = MaxAge;
+}
+
+void FGridlyPageFetcher::SetMaxPageRetries(int32 InMaxPageRetries)
+{
+	MaxPageRetries = FMath::Max(0, InMaxPageRetries);
+}
+
+void FGridlyPageFetcher::SetColumnIds(const TArray<FString>& InColumnIds)
+{
+	ColumnIdsFilter = FGenericPlatformHttp::UrlEncode(FString::Join(InColumnIds, TEXT(",")));
+}
+
+void FGridlyPageFetcher::Start()
+{
+	TotalCount = 0;
+	DecodedPages.Reset();
+	WorkerDecodedPages.Empty();
+	NumDecodingPages = 0;
+	NumRetryingPages = 0;
+	Generation++;
+	bFinished = false;
+
+	if (ViewIds.Num() == 0)
+	{
+		bFinished = true;
+		OnComplete.ExecuteIfBound();
+		return;
+	}
+
+	BeginView(0);
+}
+
+void FGridlyPageFetcher::Cancel()
+{
+	bFinished = true;
+	Generation++;
+
+	const TArray<FHttpRequestPtr> Requests = InFlightRequests;
+	InFlightRequests.Reset();
+	for (const FHttpRequestPtr& Request : Requests)
+	{
+		FGridlyRateLimiter::Get().CancelRequest(Request);
+	}
+
+	if (ReplayTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(ReplayTickerHandle);
+		ReplayTickerHandle.Reset();
+	}
+
+	if (PublishTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(PublishTickerHandle);
+		PublishTickerHandle.Reset();
+	}
+
+	SnapshotReader.Reset();
+	SnapshotWriter.Reset();
+
+	// The pages stored so far are left in place for the next fetch to resume from
+	Checkpoint.Reset();
+	ResumedPages.Reset();
+}
+
+void FGridlyPageFetcher::BeginView(int32 ViewIdIndex)
+{
+	CurrentViewIdIndex = ViewIdIndex;
+	ViewTotalCount = INDEX_NONE;
+	NextRequestOffset = 0;
+	NextCommitOffset = 0;
+
+	SnapshotReader.Reset();
+	SnapshotWriter.Reset();
+	PreviousRecordHashes.Reset();
+	PreviousPages.Reset();
+	Checkpoint.Reset();
+	ResumedPages.Reset();
+	ResumedTotalCount = INDEX_NONE;
+	PageRetries.Reset();
+
+	if (!SnapshotKind.IsEmpty())
+	{
+		SnapshotReader = FGridlySnapshotReader::Open(FGridlySnapshot::GetSnapshotPath(SnapshotKind, ViewIds[ViewIdIndex]),
+			GetSchemaHash(SnapshotSchemaHash), Limit);
+
+		if (SnapshotReader && OnCreatePage.IsBound() && FDateTime::UtcNow() - SnapshotReader->GetHeader().SyncTime < SnapshotMaxAge)
+		{
+			// Replayed on the next tick, so the fetch completes asynchronously either way
+
+			ReplayTickerHandle =
+				FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(this, &FGridlyPageFetcher::ReplaySnapshot));
+			return;
+		}
+
+		// Kept open to report what changed since the last sync, and to serve pages that were not modified
+
+		TArray<FGridlySnapshotPage> Pages;
+		if (SnapshotReader && SnapshotReader->ReadTrailer(PreviousRecordHashes, Pages))
+		{
+			for (const FGridlySnapshotPage& Page : Pages)
+			{
+				PreviousPages.Add(Page.Offset, Page);
+			}
+		}
+		else
+		{
+			SnapshotReader.Reset();
+			PreviousRecordHashes.Reset();
+		}
+	}
+
+	if (!CheckpointKind.IsEmpty() && OnCreatePage.IsBound())
+	{
+		Checkpoint = MakeUnique<FGridlyCheckpoint>(CheckpointKind, ViewIds[ViewIdIndex], GetSchemaHash(CheckpointSchemaHash),
+			Limit);
+
+		// Resumed on the next tick, so the fetch completes asynchronously either way
+
+		ReplayTickerHandle =
+			FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(this, &FGridlyPageFetcher::ResumeCheckpoint));
+		return;
+	}
+
+	DispatchRequests();
+}
+
+bool FGridlyPageFetcher::ResumeCheckpoint(float DeltaTime)
+{
+	ReplayTickerHandle.Reset();
+
+	if (bFinished || !Checkpoint)
+	{
+		return false;
+	}
+
+	TArray<TSharedRef<FGridlyPageData>> Pages;
+	int32 CheckpointTotalCount;
+	if (Checkpoint->Resume(CheckpointMaxAge, [this]() { return OnCreatePage.Execute(); }, CheckpointTotalCount, Pages))
+	{
+		for (const TSharedRef<FGridlyPageData>& PageData : Pages)
+		{
+			PageData->Page.ViewIdIndex = CurrentViewIdIndex;
+			ResumedPages.Add(PageData->Page.Offset, PageData);
+		}
+
+		// Without the first page there is nothing to check the view against
+
+		if (ResumedPages.Contains(0))
+		{
+			ResumedTotalCount = CheckpointTotalCount;
+		}
+		else
+		{
+			ResumedPages.Reset();
+		}
+	}
+
+	// Only the first page is requested until the resumed pages are validated
+
+	DispatchRequests();
+	return false;
+}
+
+void FGridlyPageFetcher::ValidateResumedPages(const FGridlyPageData& FirstPage)
+{
+	const FString& ViewId = ViewIds[CurrentViewIdIndex];
+
+	TMap<FString, uint32> RecordHashes;
+	TMap<FString, uint32> ResumedRecordHashes;
+	FirstPage.HashRecords(RecordHashes);
+	ResumedPages.FindChecked(0)->HashRecords(ResumedRecordHashes);
+
+	bool bValid = ViewTotalCount == ResumedTotalCount && RecordHashes.Num() == ResumedRecordHashes.Num();
+	for (const TPair<FString, uint32>& RecordHash : RecordHashes)
+	{
+		bValid &= ResumedRecordHashes.Contains(RecordHash.Key);
+	}
+
+	if (bValid)
+	{
+		int32 NumRecords = 0;
+		for (const TPair<int32, TSharedRef<FGridlyPageData>>& ResumedPage : ResumedPages)
+		{
+			// The first page was just fetched again, so its fresh copy is used
+			if (ResumedPage.Key > 0)
+			{
+				DecodedPages.Add(ResumedPage.Key, ResumedPage.Value);
+				NumRecords += ResumedPage.Value->NumRecords;
+			}
+		}
+
+		UE_LOG(LogGridly, Log, TEXT("Resuming view ID: %s from checkpoint, %d of %d records already fetched"), *ViewId, NumRecords,
+			ViewTotalCount);
+	}
+	else
+	{
+		UE_LOG(LogGridly, Log, TEXT("View ID: %s changed since its checkpoint, fetching it from the start"), *ViewId);
+
+		if (Checkpoint)
+		{
+			Checkpoint->Begin(ViewTotalCount);
+		}
+	}
+
+	ResumedPages.Reset();
+	ResumedTotalCount = INDEX_NONE;
+}
+
+bool FGridlyPageFetcher::ReplaySnapshot(float DeltaTime)
+{
+	ReplayTickerHandle.Reset();
+
+	const TUniquePtr<FGridlySnapshotReader> Reader = MoveTemp(SnapshotReader);
+	if (bFinished || !Reader)
+	{
+		return false;
+	}
+
+	const FString& ViewId = ViewIds[CurrentViewIdIndex];
+
+	// Read every page before committing any, so a damaged snapshot can still fall back to fetching the view
+
+	TArray<TSharedRef<FGridlyPageData>> Pages;
+	int32 Offset;
+	while (Reader->NextPage(Offset))
+	{
+		const TSharedRef<FGridlyPageData> PageData = OnCreatePage.Execute();
+		PageData->Page.ViewIdIndex = CurrentViewIdIndex;
+		PageData->Page.Offset = Offset;
+		PageData->Page.Limit = Limit;
+
+		if (!Reader->ReadPage(*PageData))
+		{
+			break;
+		}
+
+		Pages.Add(PageData);
+	}
+
+	if (Reader->HasError())
+	{
+		UE_LOG(LogGridly, Warning, TEXT("Snapshot of view ID: %s could not be read, fetching it from Gridly"), *ViewId);
+		DispatchRequests();
+		return false;
+	}
+
+	const FGridlySnapshotHeader& Header = Reader->GetHeader();
+	UE_LOG(LogGridly, Log, TEXT("Using snapshot of view ID: %s from %s (%d records)"), *ViewId, *Header.SyncTime.ToString(),
+		Header.TotalCount);
+
+	ViewTotalCount = Header.TotalCount;
+	TotalCount += ViewTotalCount;
+
+	for (const TSharedRef<FGridlyPageData>& PageData : Pages)
+	{
+		if (bFinished)
+		{
+			return false;
+		}
+
+		OnCommitPage.ExecuteIfBound(PageData);
+	}
+
+	if (!bFinished)
+	{
+		FinishView();
+	}
+
+	return false;
+}
+
+void FGridlyPageFetcher::DispatchRequests()
+{
+	// Pages resumed from a checkpoint may already be committed past the last requested offset
+
+	NextRequestOffset = FMath::Max(NextRequestOffset, NextCommitOffset);
+
+	while (!bFinished && InFlightRequests.Num() + NumRetryingPages < MaxConcurrentRequests)
+	{
+		// Until the first page has returned the total count, and validated any pages resumed from a checkpoint, only the
+		// first page can be requested
+
+		const bool bCanRequest = NextRequestOffset == 0
+		                         || (ViewTotalCount != INDEX_NONE && ResumedPages.Num() == 0 && NextRequestOffset < ViewTotalCount);
+		if (!bCanRequest)
+		{
+			break;
+		}
+
+		FGridlyPageRequest Page;
+		Page.ViewIdIndex = CurrentViewIdIndex;
+		Page.Offset = NextRequestOffset;
+		Page.Limit = Limit;
+
+		NextRequestOffset += Limit;
+
+		// Pages resumed from a checkpoint are not requested again
+		if (DecodedPages.Contains(Page.Offset))
+		{
+			continue;
+		}
+
+		SendRequest(Page);
+	}
+}
+
+void FGridlyPageFetcher::SendRequest(const FGridlyPageRequest& Page)
+{
+	const FString& ViewId = ViewIds[Page.ViewIdIndex];
+
+	const FString PaginationSettings =
+		FGenericPlatformHttp::UrlEncode(FString::Printf(TEXT("{\"offset\":%d,\"limit\":%d}"), Page.Offset, Page.Limit));
+
+	FStringFormatNamedArguments Args;
+	Args.Add(TEXT("ViewId"), *ViewId);
+	Args.Add(TEXT("PaginationSettings"), *PaginationSettings);
+	FString Url = FGridlyHttp::GetApiUrl(FString::Format(TEXT("/v1/views/{ViewId}/records?page={PaginationSettings}"),
+		Args));
+
+	if (!ColumnIdsFilter.IsEmpty())
+	{
+		Url += TEXT("&columnIds=") + ColumnIdsFilter;
+	}
+
+	const FHttpRequestRef HttpRequest = FGridlyHttp::CreateRequest(TEXT("GET"), Url, ApiKey);
+	HttpRequest->SetHeader(TEXT("Accept"), TEXT("application/json"));
+	HttpRequest->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
+
+	// The first page is always fetched in full, since X-Total-Count may have changed even if its records have not
+
+	const FGridlySnapshotPage* PreviousPage = Page.Offset > 0 ? PreviousPages.Find(Page.Offset) : nullptr;
+	if (PreviousPage && !PreviousPage->ETag.IsEmpty())
+	{
+		HttpRequest->SetHeader(TEXT("If-None-Match"), PreviousPage->ETag);
+	}
+	else if (PreviousPage && !PreviousPage->LastModified.IsEmpty())
+	{
+		HttpRequest->SetHeader(TEXT("If-Modified-Since"), PreviousPage->LastModified);
+	}
+
+	HttpRequest->OnProcessRequestComplete().BindSP(this, &FGridlyPageFetcher::OnRequestComplete, Page);
+
+	InFlightRequests.Add(HttpRequest);
+
+	// Throttled through the budget shared by all Gridly requests
+
+	FGridlyRateLimiter::Get().ProcessRequest(HttpRequest);
+	UE_LOG(LogGridly, Log, TEXT("Requesting view ID: %s, with offset: %d, limit: %d"), *ViewId, Page.Offset, Page.Limit);
+}
+
+void FGridlyPageFetcher::OnRequestComplete(FHttpRequestPtr HttpRequestPtr, FHttpResponsePtr HttpResponsePtr, bool bSuccess,
+	FGridlyPageRequest Page)
+{
+	InFlightRequests.Remove(HttpRequestPtr);
+
+	if (bFinished)
+	{
+		return;
+	}
+
+	const int32 ResponseCode = HttpResponsePtr.IsValid() ? HttpResponsePtr->GetResponseCode() : 0;
+
+	if (bSuccess && ResponseCode == EHttpResponseCodes::NotModified)
+	{
+		OnPageNotModified(Page);
+		return;
+	}
+
+	if (!bSuccess || ResponseCode != EHttpResponseCodes::Ok)
+	{
+		// Client errors, such as a wrong API key or view ID, fail the same way every time
+
+		const bool bRetryable = !bSuccess || ResponseCode >= 500 || ResponseCode == EHttpResponseCodes::RequestTimeout;
+		if (!bRetryable || !RetryPage(Page))
+		{
+			Fail(TEXT("Failed to connect to Gridly"));
+		}
+		return;
+	}
+
+	// Header
+
+	TArray<FString> Headers = HttpResponsePtr->GetAllHeaders();
+	for (int i = 0; i < Headers.Num(); i++)
+	{
+		UE_LOG(LogGridly, Verbose, TEXT("%s"), *Headers[i]);
+	}
+
+	// Pages resumed from a checkpoint keep being stored until the first page is decoded and compared with them
+
+	if (Page.Offset == 0 && ViewTotalCount == INDEX_NONE)
+	{
+		SetViewTotalCount(FMath::Max(0, FCString::Atoi(*HttpResponsePtr->GetHeader(TEXT("X-Total-Count")))));
+
+		if (Checkpoint && ResumedPages.Num() == 0)
+		{
+			Checkpoint->Begin(ViewTotalCount);
+		}
+	}
+
+	// The page is decoded off the game thread, while the next pages are requested
+
+	DecodePage(Page, HttpResponsePtr);
+	DispatchRequests();
+}
+
+void FGridlyPageFetcher::DecodePage(const FGridlyPageRequest& Page, FHttpResponsePtr HttpResponsePtr)
+{
+	NumDecodingPages++;
+
+	if (!PublishTickerHandle.IsValid())
+	{
+		PublishTickerHandle =
+			FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(this, &FGridlyPageFetcher::PublishDecodedPages));
+	}
+
+	UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, This = AsShared(), Page, HttpResponsePtr, DecodeGeneration = Generation]()
+	{
+		const TSharedPtr<FGridlyPageData> PageData = OnDecodePage.IsBound() ? OnDecodePage.Execute(Page, HttpResponsePtr) : nullptr;
+		if (PageData.IsValid())
+		{
+			PageData->Page = Page;
+			PageData->ETag = HttpResponsePtr->GetHeader(TEXT("ETag"));
+			PageData->LastModified = HttpResponsePtr->GetHeader(TEXT("Last-Modified"));
+		}
+
+		WorkerDecodedPages.Enqueue(FWorkerDecodedPage{DecodeGeneration, Page, PageData});
+	});
+}
+
+bool FGridlyPageFetcher::PublishDecodedPages(float DeltaTime)
+{
+	// Every page decoded since the last tick is committed as one batch
+
+	bool bPublished = false;
+
+	FWorkerDecodedPage WorkerDecodedPage;
+	while (WorkerDecodedPages.Dequeue(WorkerDecodedPage))
+	{
+		if (WorkerDecodedPage.Generation != Generation)
+		{
+			continue;
+		}
+
+		NumDecodingPages--;
+
+		// A response cut short can fail to decode, so the page is requested again
+
+		if (!WorkerDecodedPage.PageData.IsValid())
+		{
+			if (RetryPage(WorkerDecodedPage.Page))
+			{
+				continue;
+			}
+
+			PublishTickerHandle.Reset();
+			Fail(TEXT("Failed to parse downloaded content"));
+			return false;
+		}
+
+		// Validated before the first page is stored, which restarts the checkpoint if the view has changed
+
+		if (WorkerDecodedPage.Page.Offset == 0 && ResumedPages.Num() > 0)
+		{
+			ValidateResumedPages(*WorkerDecodedPage.PageData);
+		}
+
+		if (Checkpoint)
+		{
+			Checkpoint->WritePage(*WorkerDecodedPage.PageData);
+		}
+
+		DecodedPages.Add(WorkerDecodedPage.Page.Offset, WorkerDecodedPage.PageData);
+		bPublished = true;
+	}
+
+	if (bPublished && !bFinished)
+	{
+		CommitPages();
+		DispatchRequests();
+	}
+
+	// Keeps ticking while pages are still being decoded
+
+	if (bFinished || NumDecodingPages == 0)
+	{
+		PublishTickerHandle.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+void FGridlyPageFetcher::OnPageNotModified(const FGridlyPageRequest& Page)
+{
+	const FGridlySnapshotPage* PreviousPage = PreviousPages.Find(Page.Offset);
+	const TSharedPtr<FGridlyPageData> PageData = OnCreatePage.IsBound() ? OnCreatePage.Execute() : TSharedPtr<FGridlyPageData>();
+
+	if (!PreviousPage || !SnapshotReader || !PageData.IsValid() || !SnapshotReader->ReadPageAt(*PreviousPage, *PageData))
+	{
+		Fail(TEXT("Failed to read unmodified page from snapshot"));
+		return;
+	}
+
+	UE_LOG(LogGridly, Verbose, TEXT("Page with offset: %d not modified, using snapshot"), Page.Offset);
+
+	PageData->Page = Page;
+	PageData->ETag = PreviousPage->ETag;
+	PageData->LastModified = PreviousPage->LastModified;
+	DecodedPages.Add(Page.Offset, PageData);
+
+	if (Checkpoint)
+	{
+		Checkpoint->WritePage(*PageData);
+	}
+
+	CommitPages();
+	DispatchRequests();
+}
+
+void FGridlyPageFetcher::SetViewTotalCount(int32 InViewTotalCount)
+{
+	ViewTotalCount = InViewTotalCount;
+	TotalCount += ViewTotalCount;
+
+	if (!SnapshotKind.IsEmpty())
+	{
+		SnapshotWriter = FGridlySnapshotWriter::Create(FGridlySnapshot::GetSnapshotPath(SnapshotKind, ViewIds[CurrentViewIdIndex]),
+			GetSchemaHash(SnapshotSchemaHash), Limit, ViewTotalCount);
+	}
+}
+
+bool FGridlyPageFetcher::RetryPage(const FGridlyPageRequest& Page)
+{
+	int32& NumRetries = PageRetries.FindOrAdd(Page.Offset);
+	if (NumRetries >= MaxPageRetries)
+	{
+		return false;
+	}
+
+	NumRetries++;
+
+	// Waits 1, 2, 4... seconds, while the other pages keep downloading
+
+	const float Delay = FMath::Min(static_cast<float>(1 << FMath::Min(NumRetries - 1, 5)), 30.f);
+	UE_LOG(LogGridly, Warning, TEXT("Page with offset: %d of view ID: %s failed, retrying in %.0f seconds (%d of %d)"),
+		Page.Offset, *ViewIds[Page.ViewIdIndex], Delay, NumRetries, MaxPageRetries);
+
+	NumRetryingPages++;
+	FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateSP(this, &FGridlyPageFetcher::OnRetryDelayElapsed, Page, Generation), Delay);
+
+	return true;
+}
+
+bool FGridlyPageFetcher::OnRetryDelayElapsed(float DeltaTime, FGridlyPageRequest Page, uint32 RetryGeneration)
+{
+	if (!bFinished && RetryGeneration == Generation)
+	{
+		NumRetryingPages--;
+		SendRequest(Page);
+	}
+
+	return false;
+}
+
+void FGridlyPageFetcher::CommitPages()
+{
+	while (!bFinished)
+	{
+		TSharedPtr<FGridlyPageData> PageData;
+		if (!DecodedPages.RemoveAndCopyValue(NextCommitOffset, PageData))
+		{
+			break;
+		}
+
+		NextCommitOffset += Limit;
+
+		// Written before the task takes over the page
+		if (SnapshotWriter)
+		{
+			SnapshotWriter->WritePage(*PageData);
+		}
+
+		OnCommitPage.ExecuteIfBound(PageData.ToSharedRef());
+	}
+
+	const bool bViewComplete = ViewTotalCount != INDEX_NONE && NextCommitOffset > 0 && NextCommitOffset >= ViewTotalCount;
+	if (!bFinished && bViewComplete)
+	{
+		FinishView();
+	}
+}
+
+void FGridlyPageFetcher::FinishView()
+{
+	SnapshotReader.Reset();
+	PreviousPages.Reset();
+
+	if (Checkpoint)
+	{
+		Checkpoint->Delete();
+		Checkpoint.Reset();
+	}
+
+	if (SnapshotWriter)
+	{
+		const FGridlySnapshotDiff Diff = FGridlySnapshotDiff::Compare(PreviousRecordHashes, SnapshotWriter->GetRecordHashes());
+		UE_LOG(LogGridly, Log, TEXT("View ID: %s since last sync: %d added, %d changed, %d removed, %d unchanged"),
+			*ViewIds[CurrentViewIdIndex], Diff.NumAdded, Diff.NumChanged, Diff.NumRemoved, Diff.NumUnchanged);
+
+		SnapshotWriter->Finish();
+		SnapshotWriter.Reset();
+	}
+
+	if (CurrentViewIdIndex + 1 < ViewIds.Num())
+	{
+		BeginView(CurrentViewIdIndex + 1);
+	}
+	else
+	{
+		bFinished = true;
+		OnComplete.ExecuteIfBound();
+	}
+}
+
+void FGridlyPageFetcher::Fail(const FString& Message)
+{
+	Cancel();
+	UE_LOG(LogGridly, Error, TEXT("%s"), *Message);
+	OnFail.ExecuteIfBound(Message);
+}
+
+uint32 FGridlyPageFetcher::GetSchemaHash(uint32 SchemaHash) const
+{
+	// Pages fetched with other columns hold other cells, so they are not replayed or resumed
+
+	return ColumnIdsFilter.IsEmpty() ? SchemaHash : HashCombine(SchemaHash, GetTypeHash(ColumnIdsFilter));
+}
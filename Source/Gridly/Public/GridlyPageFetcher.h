@@ -0,0 +1,178 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Containers/Queue.h"
+#include "Containers/Ticker.h"
+#include "GridlyCheckpoint.h"
+#include "GridlySnapshot.h"
+#include "Interfaces/IHttpRequest.h"
+
+/** A single page of records requested from a Gridly view */
+struct GRIDLY_API FGridlyPageRequest
+{
+	int32 ViewIdIndex = 0;
+	int32 Offset = 0;
+	int32 Limit = 0;
+};
+
+/** Decoded contents of a page. Each task derives from this to hold its own record type */
+struct GRIDLY_API FGridlyPageData
+{
+	virtual ~FGridlyPageData() = default;
+
+	/** Reads or writes the decoded records in a compact binary form, used by view snapshots */
+	virtual void Serialize(FArchive& Ar) { Ar << NumRecords; }
+
+	/** Adds a content hash for each record, keyed by record ID */
+	virtual void HashRecords(TMap<FString, uint32>& OutRecordHashes) const {}
+
+	FGridlyPageRequest Page;
+	int32 NumRecords = 0;
+
+	/** Validators returned with the page, sent back as If-None-Match / If-Modified-Since on the next fetch */
+	FString ETag;
+	FString LastModified;
+};
+
+DECLARE_DELEGATE_RetVal_TwoParams(TSharedPtr<FGridlyPageData>, FGridlyDecodePageDelegate, const FGridlyPageRequest&,
+	FHttpResponsePtr);
+DECLARE_DELEGATE_RetVal(TSharedRef<FGridlyPageData>, FGridlyCreatePageDelegate);
+DECLARE_DELEGATE_OneParam(FGridlyCommitPageDelegate, const TSharedRef<FGridlyPageData>&);
+DECLARE_DELEGATE(FGridlyFetchCompleteDelegate);
+DECLARE_DELEGATE_OneParam(FGridlyFetchFailDelegate, const FString&);
+
+/**
+ * Fetches every page of a list of Gridly views. Once the first page of a view has returned X-Total-Count, the remaining
+ * offsets are requested through a window of concurrent requests. Pages are decoded on worker threads as soon as they
+ * arrive, while the next requests are already in flight, and committed on the game thread in offset order.
+ *
+ * With snapshots enabled, the decoded pages of each view are also written to Saved/Gridly/Snapshots. A snapshot younger
+ * than the max age is replayed instead of fetching the view again. Otherwise pages are requested conditionally, and
+ * pages Gridly reports as not modified are read back from the previous snapshot.
+ *
+ * With checkpoints enabled, every decoded page is also stored until its view is fully fetched. A fetch that fails or is
+ * cancelled leaves them in place, and the next fetch of the view only requests the pages that are missing. The first page
+ * is always fetched again first, and the stored pages are discarded unless its total count and record IDs still match, since
+ * records added or deleted since then shift every offset. Failed page requests are retried with a growing delay before the
+ * fetch gives up.
+ */
+class GRIDLY_API FGridlyPageFetcher : public TSharedFromThis<FGridlyPageFetcher>
+{
+public:
+	FGridlyPageFetcher(const TArray<FString>& InViewIds, const FString& InApiKey, int32 InLimit, int32 InMaxConcurrentRequests);
+
+	/** Kind separates the snapshots of decoders with different page types, SchemaHash invalidates them when decoding changes */
+	void EnableSnapshots(const FString& Kind, uint32 SchemaHash, const FTimespan& MaxAge);
+
+	/** Checkpoints older than MaxAge are discarded rather than resumed */
+	void EnableCheckpoints(const FString& Kind, uint32 SchemaHash, const FTimespan& MaxAge);
+
+	/** How many times each page is requested again after a failed request or an undecodable response */
+	void SetMaxPageRetries(int32 InMaxPageRetries);
+
+	/** Only these columns are requested from Gridly. Records are returned with the matching cells only, all of them if empty */
+	void SetColumnIds(const TArray<FString>& InColumnIds);
+
+	void Start();
+	void Cancel();
+
+	int32 GetNumViews() const { return ViewIds.Num(); }
+	int32 GetCurrentViewIdIndex() const { return CurrentViewIdIndex; }
+	int32 GetTotalCount() const { return TotalCount; }
+
+public:
+	/** Called on a worker thread as soon as a page arrives, in any order. Returning nullptr fails the fetch */
+	FGridlyDecodePageDelegate OnDecodePage;
+
+	/** Creates an empty page to read a snapshot into. Required for snapshots */
+	FGridlyCreatePageDelegate OnCreatePage;
+
+	/** Called for each decoded page in view and offset order */
+	FGridlyCommitPageDelegate OnCommitPage;
+
+	FGridlyFetchCompleteDelegate OnComplete;
+	FGridlyFetchFailDelegate OnFail;
+
+private:
+	void DispatchRequests();
+	void SendRequest(const FGridlyPageRequest& Page);
+	void OnRequestComplete(FHttpRequestPtr HttpRequestPtr, FHttpResponsePtr HttpResponsePtr, bool bSuccess,
+		FGridlyPageRequest Page);
+	void OnPageNotModified(const FGridlyPageRequest& Page);
+	void SetViewTotalCount(int32 InViewTotalCount);
+	bool RetryPage(const FGridlyPageRequest& Page);
+	bool OnRetryDelayElapsed(float DeltaTime, FGridlyPageRequest Page, uint32 RetryGeneration);
+	void DecodePage(const FGridlyPageRequest& Page, FHttpResponsePtr HttpResponsePtr);
+	bool PublishDecodedPages(float DeltaTime);
+	void CommitPages();
+	void BeginView(int32 ViewIdIndex);
+	void FinishView();
+	bool ReplaySnapshot(float DeltaTime);
+	bool ResumeCheckpoint(float DeltaTime);
+	void ValidateResumedPages(const FGridlyPageData& FirstPage);
+	void Fail(const FString& Message);
+	uint32 GetSchemaHash(uint32 SchemaHash) const;
+
+private:
+	TArray<FString> ViewIds;
+	FString ApiKey;
+	int32 Limit;
+	int32 MaxConcurrentRequests;
+	int32 MaxPageRetries;
+
+	/** Comma-separated column IDs, already URL encoded */
+	FString ColumnIdsFilter;
+
+	int32 CurrentViewIdIndex;
+	int32 ViewTotalCount;
+	int32 NextRequestOffset;
+	int32 NextCommitOffset;
+	int32 TotalCount;
+
+	TArray<FHttpRequestPtr> InFlightRequests;
+
+	/** Failed attempts of each page of the current view, and the pages waiting to be requested again */
+	TMap<int32, int32> PageRetries;
+	int32 NumRetryingPages;
+	TMap<int32, TSharedPtr<FGridlyPageData>> DecodedPages;
+
+	/** A page decoded on a worker thread, waiting to be picked up by the game thread */
+	struct FWorkerDecodedPage
+	{
+		uint32 Generation;
+		FGridlyPageRequest Page;
+		TSharedPtr<FGridlyPageData> PageData;
+	};
+
+	TQueue<FWorkerDecodedPage, EQueueMode::Mpsc> WorkerDecodedPages;
+	int32 NumDecodingPages;
+
+	/** Bumped on every start and cancel, so pages still being decoded for an earlier fetch are dropped */
+	uint32 Generation;
+	FTSTicker::FDelegateHandle PublishTickerHandle;
+
+	bool bFinished;
+
+	FString SnapshotKind;
+	uint32 SnapshotSchemaHash;
+	FTimespan SnapshotMaxAge;
+
+	TUniquePtr<FGridlySnapshotReader> SnapshotReader;
+	TUniquePtr<FGridlySnapshotWriter> SnapshotWriter;
+	TMap<FString, uint32> PreviousRecordHashes;
+	TMap<int32, FGridlySnapshotPage> PreviousPages;
+	FTSTicker::FDelegateHandle ReplayTickerHandle;
+
+	FString CheckpointKind;
+	uint32 CheckpointSchemaHash;
+	FTimespan CheckpointMaxAge;
+
+	TUniquePtr<FGridlyCheckpoint> Checkpoint;
+
+	/** Pages read from the checkpoint, held back until the refetched first page shows they are still valid */
+	TMap<int32, TSharedRef<FGridlyPageData>> ResumedPages;
+	int32 ResumedTotalCount;
+};
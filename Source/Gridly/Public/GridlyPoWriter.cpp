@@ -0,0 +1,154 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#include "GridlyPoWriter.h"
+
+// The buffer is flushed to the archive whenever it grows past this size
+static constexpr int32 GridlyPoWriterFlushSize = 256 * 1024;
+
+FGridlyPoWriter::FGridlyPoWriter(FArchive& InArchive) :
+	Archive(InArchive),
+	NumLines(0)
+{
+	Buffer.Reserve(GridlyPoWriterFlushSize + 4096);
+}
+
+FGridlyPoWriter::~FGridlyPoWriter()
+{
+	Flush();
+}
+
+void FGridlyPoWriter::WriteByteOrderMark()
+{
+	Buffer.Add(0xEF);
+	Buffer.Add(0xBB);
+	Buffer.Add(0xBF);
+}
+
+void FGridlyPoWriter::WriteEntry(const FString& Namespace, const FString& Key, const FString& NativeString,
+	const FString& LocalizedString)
+{
+	AppendLiteral("msgctxt \"");
+	AppendString(Namespace, false);
+	AppendLiteral(",");
+	AppendString(Key, false);
+	AppendLiteral("\"");
+	AppendLineTerminator();
+
+	AppendLiteral("msgid \"");
+	AppendString(NativeString, true);
+	AppendLiteral("\"");
+	AppendLineTerminator();
+
+	AppendLiteral("msgstr \"");
+	AppendString(LocalizedString, true);
+	AppendLiteral("\"");
+	AppendLineTerminator();
+
+	AppendLineTerminator();
+
+	if (Buffer.Num() >= GridlyPoWriterFlushSize)
+	{
+		Flush();
+	}
+}
+
+bool FGridlyPoWriter::Flush()
+{
+	if (Buffer.Num() > 0)
+	{
+		Archive.Serialize(Buffer.GetData(), Buffer.Num());
+		Buffer.Reset();
+	}
+
+	return !Archive.IsError();
+}
+
+void FGridlyPoWriter::AppendLiteral(const ANSICHAR* Literal)
+{
+	Buffer.Append(reinterpret_cast<const uint8*>(Literal), FCStringAnsi::Strlen(Literal));
+}
+
+void FGridlyPoWriter::AppendString(const FString& String, bool bEscape)
+{
+	// Same escapes as ConditionArchiveStrForPO, in one pass
+
+	const TCHAR* Chars = *String;
+	const int32 Len = String.Len();
+
+	for (int32 i = 0; i < Len; i++)
+	{
+		const TCHAR Char = Chars[i];
+
+		if (bEscape)
+		{
+			ANSICHAR Escaped = 0;
+			switch (Char)
+			{
+			case TEXT('\\'): Escaped = '\\'; break;
+			case TEXT('"'): Escaped = '"'; break;
+			case TEXT('\r'): Escaped = 'r'; break;
+			case TEXT('\n'): Escaped = 'n'; break;
+			case TEXT('\t'): Escaped = 't'; break;
+			default: break;
+			}
+
+			if (Escaped != 0)
+			{
+				Buffer.Add('\\');
+				Buffer.Add(Escaped);
+				continue;
+			}
+		}
+
+		if (static_cast<uint32>(Char) < 0x80)
+		{
+			Buffer.Add(static_cast<uint8>(Char));
+			continue;
+		}
+
+		uint32 CodePoint = static_cast<uint32>(Char);
+
+		// UTF-16 surrogate pairs, when TCHAR is 2 bytes wide
+
+		if (CodePoint >= 0xD800 && CodePoint <= 0xDBFF && i + 1 < Len)
+		{
+			const uint32 LowSurrogate = static_cast<uint32>(Chars[i + 1]);
+			if (LowSurrogate >= 0xDC00 && LowSurrogate <= 0xDFFF)
+			{
+				CodePoint = 0x10000 + ((CodePoint - 0xD800) << 10) + (LowSurrogate - 0xDC00);
+				i++;
+			}
+		}
+
+		AppendCodePoint(CodePoint);
+	}
+}
+
+void FGridlyPoWriter::AppendCodePoint(uint32 CodePoint)
+{
+	if (CodePoint < 0x800)
+	{
+		Buffer.Add(static_cast<uint8>(0xC0 | (CodePoint >> 6)));
+		Buffer.Add(static_cast<uint8>(0x80 | (CodePoint & 0x3F)));
+	}
+	else if (CodePoint < 0x10000)
+	{
+		Buffer.Add(static_cast<uint8>(0xE0 | (CodePoint >> 12)));
+		Buffer.Add(static_cast<uint8>(0x80 | ((CodePoint >> 6) & 0x3F)));
+		Buffer.Add(static_cast<uint8>(0x80 | (CodePoint & 0x3F)));
+	}
+	else
+	{
+		Buffer.Add(static_cast<uint8>(0xF0 | (CodePoint >> 18)));
+		Buffer.Add(static_cast<uint8>(0x80 | ((CodePoint >> 12) & 0x3F)));
+		Buffer.Add(static_cast<uint8>(0x80 | ((CodePoint >> 6) & 0x3F)));
+		Buffer.Add(static_cast<uint8>(0x80 | (CodePoint & 0x3F)));
+	}
+}
+
+void FGridlyPoWriter::AppendLineTerminator()
+{
+	// Matches the line endings FFileHelper::SaveStringArrayToFile wrote
+	AppendLiteral(LINE_TERMINATOR_ANSI);
+	NumLines++;
+}
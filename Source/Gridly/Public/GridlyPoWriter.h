@@ -0,0 +1,36 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Streams .po entries to an archive as UTF-8. Strings are escaped in a single scan straight into one reusable buffer, which
+ * is flushed to the archive in large blocks.
+ */
+class GRIDLY_API FGridlyPoWriter
+{
+public:
+	explicit FGridlyPoWriter(FArchive& InArchive);
+	~FGridlyPoWriter();
+
+	void WriteByteOrderMark();
+
+	/** Writes msgctxt, msgid and msgstr followed by an empty line. The context is written as is, like the import expects */
+	void WriteEntry(const FString& Namespace, const FString& Key, const FString& NativeString, const FString& LocalizedString);
+
+	bool Flush();
+
+	int32 GetNumLines() const { return NumLines; }
+
+private:
+	void AppendLiteral(const ANSICHAR* Literal);
+	void AppendString(const FString& String, bool bEscape);
+	void AppendCodePoint(uint32 CodePoint);
+	void AppendLineTerminator();
+
+private:
+	FArchive& Archive;
+	TArray<uint8> Buffer;
+	int32 NumLines;
+};
@@ -0,0 +1,260 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#include "GridlyRateLimiter.h"
+
+#include "Gridly.h"
+#include "GridlyGameSettings.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Misc/DateTime.h"
+
+// Lowest rate the limiter backs off to, in requests per second
+static constexpr double GridlyMinRequestsPerSecond = 0.1;
+
+// Rate added for every healthy response, in requests per second
+static constexpr double GridlyRateIncreaseStep = 0.1;
+
+// Upper bound for the exponential backoff between retries, in seconds
+static constexpr double GridlyMaxBackoff = 60.0;
+
+FGridlyRateLimiter& FGridlyRateLimiter::Get()
+{
+	static FGridlyRateLimiter RateLimiter;
+	return RateLimiter;
+}
+
+FGridlyRateLimiter::FGridlyRateLimiter() :
+	Rate(0.0),
+	Tokens(1.0),
+	LastRefillTime(FPlatformTime::Seconds()),
+	BlockedUntil(0.0)
+{
+	const UGridlyGameSettings* GameSettings = GetDefault<UGridlyGameSettings>();
+	Rate = FMath::Max(GridlyMinRequestsPerSecond, static_cast<double>(GameSettings->ApiInitialRequestsPerSecond));
+}
+
+void FGridlyRateLimiter::ProcessRequest(const FHttpRequestRef& HttpRequest)
+{
+	const TSharedRef<FQueuedRequest> QueuedRequest = MakeShared<FQueuedRequest>(HttpRequest);
+	QueuedRequest->OnComplete = HttpRequest->OnProcessRequestComplete();
+
+	{
+		FScopeLock Lock(&CriticalSection);
+		Queue.Add(QueuedRequest);
+	}
+
+	DispatchQueuedRequests();
+}
+
+void FGridlyRateLimiter::CancelRequest(const FHttpRequestPtr& HttpRequest)
+{
+	TArray<TSharedRef<FQueuedRequest>> Cancelled;
+
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		auto IsCancelled = [&HttpRequest](const TSharedRef<FQueuedRequest>& QueuedRequest)
+		{
+			return QueuedRequest->OriginalRequest == HttpRequest;
+		};
+
+		for (const TSharedRef<FQueuedRequest>& QueuedRequest : InFlight)
+		{
+			if (IsCancelled(QueuedRequest))
+			{
+				Cancelled.Add(QueuedRequest);
+			}
+		}
+
+		Queue.RemoveAll(IsCancelled);
+		InFlight.RemoveAll(IsCancelled);
+	}
+
+	for (const TSharedRef<FQueuedRequest>& QueuedRequest : Cancelled)
+	{
+		QueuedRequest->Request->OnProcessRequestComplete().Unbind();
+		QueuedRequest->Request->CancelRequest();
+	}
+}
+
+float FGridlyRateLimiter::GetCurrentRate() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return static_cast<float>(Rate);
+}
+
+void FGridlyRateLimiter::RefillTokens(double Now)
+{
+	const double Burst = FMath::Max(1.0, Rate);
+	Tokens = FMath::Min(Burst, Tokens + (Now - LastRefillTime) * Rate);
+	LastRefillTime = Now;
+}
+
+void FGridlyRateLimiter::DispatchQueuedRequests()
+{
+	TArray<TSharedRef<FQueuedRequest>> ReadyRequests;
+	bool bHasQueuedRequests = false;
+
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		const double Now = FPlatformTime::Seconds();
+		RefillTokens(Now);
+
+		if (Now >= BlockedUntil)
+		{
+			for (int32 i = 0; i < Queue.Num() && Tokens >= 1.0;)
+			{
+				if (Queue[i]->NotBefore <= Now)
+				{
+					Tokens -= 1.0;
+					ReadyRequests.Add(Queue[i]);
+					InFlight.Add(Queue[i]);
+					Queue.RemoveAt(i);
+				}
+				else
+				{
+					i++;
+				}
+			}
+		}
+
+		bHasQueuedRequests = Queue.Num() > 0;
+
+		if (bHasQueuedRequests && !TickerHandle.IsValid())
+		{
+			TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FGridlyRateLimiter::Tick));
+		}
+	}
+
+	for (const TSharedRef<FQueuedRequest>& QueuedRequest : ReadyRequests)
+	{
+		Send(QueuedRequest);
+	}
+}
+
+bool FGridlyRateLimiter::Tick(float DeltaTime)
+{
+	DispatchQueuedRequests();
+
+	FScopeLock Lock(&CriticalSection);
+	if (Queue.Num() == 0)
+	{
+		TickerHandle.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+void FGridlyRateLimiter::Send(const TSharedRef<FQueuedRequest>& QueuedRequest)
+{
+	QueuedRequest->Request->OnProcessRequestComplete().BindRaw(this, &FGridlyRateLimiter::OnRequestComplete, QueuedRequest);
+	QueuedRequest->Request->ProcessRequest();
+}
+
+void FGridlyRateLimiter::OnRequestComplete(FHttpRequestPtr HttpRequestPtr, FHttpResponsePtr HttpResponsePtr, bool bSuccess,
+	TSharedRef<FQueuedRequest> QueuedRequest)
+{
+	const int32 ResponseCode = HttpResponsePtr.IsValid() ? HttpResponsePtr->GetResponseCode() : 0;
+	const bool bThrottled = ResponseCode == EHttpResponseCodes::TooManyRequests || ResponseCode == EHttpResponseCodes::ServiceUnavail;
+	const int32 MaxRetries = GetDefault<UGridlyGameSettings>()->ApiMaxRetries;
+
+	bool bRetry = false;
+
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		if (InFlight.Remove(QueuedRequest) == 0)
+		{
+			// Cancelled while in flight
+			return;
+		}
+
+		if (bThrottled)
+		{
+			const double Delay = GetRetryDelay(HttpResponsePtr, QueuedRequest->Attempt);
+			const double Now = FPlatformTime::Seconds();
+
+			// Multiplicative decrease, and hold back every request until the server is ready again
+
+			Rate = FMath::Max(GridlyMinRequestsPerSecond, Rate * 0.5);
+			Tokens = FMath::Min(Tokens, 0.0);
+			BlockedUntil = FMath::Max(BlockedUntil, Now + Delay);
+
+			if (QueuedRequest->Attempt < MaxRetries)
+			{
+				QueuedRequest->Attempt++;
+				QueuedRequest->NotBefore = Now + Delay;
+				QueuedRequest->Request = CloneRequest(QueuedRequest->Request);
+				Queue.Insert(QueuedRequest, 0);
+				bRetry = true;
+			}
+
+			UE_LOG(LogGridly, Warning, TEXT("Gridly responded %d, backing off for %.1f seconds (rate: %.2f requests/s)"),
+				ResponseCode, Delay, Rate);
+		}
+		else if (bSuccess)
+		{
+			// Additive increase while the server stays healthy
+
+			const double MaxRate = FMath::Max(GridlyMinRequestsPerSecond,
+				static_cast<double>(GetDefault<UGridlyGameSettings>()->ApiMaxRequestsPerSecond));
+			Rate = FMath::Min(MaxRate, Rate + GridlyRateIncreaseStep);
+		}
+	}
+
+	if (bRetry)
+	{
+		DispatchQueuedRequests();
+		return;
+	}
+
+	QueuedRequest->OnComplete.ExecuteIfBound(QueuedRequest->OriginalRequest, HttpResponsePtr, bSuccess);
+}
+
+double FGridlyRateLimiter::GetRetryDelay(const FHttpResponsePtr& HttpResponsePtr, int32 Attempt) const
+{
+	// Jittered exponential backoff
+
+	const double Backoff = FMath::Min(GridlyMaxBackoff, FMath::Pow(2.0, static_cast<double>(Attempt)));
+	double Delay = Backoff * FMath::FRandRange(0.5, 1.0);
+
+	// Retry-After is either a number of seconds or an HTTP date
+
+	const FString RetryAfter = HttpResponsePtr.IsValid() ? HttpResponsePtr->GetHeader(TEXT("Retry-After")) : FString();
+	if (!RetryAfter.IsEmpty())
+	{
+		FDateTime RetryDate;
+		if (RetryAfter.IsNumeric())
+		{
+			Delay = FMath::Max(Delay, FCString::Atod(*RetryAfter));
+		}
+		else if (FDateTime::ParseHttpDate(RetryAfter, RetryDate))
+		{
+			Delay = FMath::Max(Delay, (RetryDate - FDateTime::UtcNow()).GetTotalSeconds());
+		}
+	}
+
+	return Delay;
+}
+
+FHttpRequestRef FGridlyRateLimiter::CloneRequest(const FHttpRequestRef& HttpRequest)
+{
+	const FHttpRequestRef NewHttpRequest = FHttpModule::Get().CreateRequest();
+	NewHttpRequest->SetVerb(HttpRequest->GetVerb());
+	NewHttpRequest->SetURL(HttpRequest->GetURL());
+
+	for (const FString& Header : HttpRequest->GetAllHeaders())
+	{
+		FString HeaderName, HeaderValue;
+		if (Header.Split(TEXT(": "), &HeaderName, &HeaderValue))
+		{
+			NewHttpRequest->SetHeader(HeaderName, HeaderValue);
+		}
+	}
+
+	NewHttpRequest->SetContent(HttpRequest->GetContent());
+
+	return NewHttpRequest;
+}
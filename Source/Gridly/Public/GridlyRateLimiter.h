@@ -0,0 +1,68 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Containers/Ticker.h"
+#include "Interfaces/IHttpRequest.h"
+
+/**
+ * Shared request budget for all Gridly API traffic. Requests are sent through a token bucket whose rate grows additively
+ * while responses are healthy and is halved on 429/503 responses. Throttled requests are retried transparently after
+ * Retry-After or a jittered exponential backoff, before the request's own completion delegate is called.
+ */
+class GRIDLY_API FGridlyRateLimiter
+{
+public:
+	static FGridlyRateLimiter& Get();
+
+	/** Sends the request as soon as the budget allows it. Bind OnProcessRequestComplete before calling this */
+	void ProcessRequest(const FHttpRequestRef& HttpRequest);
+
+	/** Cancels a request that was passed to ProcessRequest, whether it has been sent yet or not */
+	void CancelRequest(const FHttpRequestPtr& HttpRequest);
+
+	float GetCurrentRate() const;
+
+private:
+	struct FQueuedRequest
+	{
+		FHttpRequestRef OriginalRequest;
+		FHttpRequestRef Request;
+		FHttpRequestCompleteDelegate OnComplete;
+		double NotBefore = 0.0;
+		int32 Attempt = 0;
+
+		FQueuedRequest(const FHttpRequestRef& InRequest) :
+			OriginalRequest(InRequest),
+			Request(InRequest)
+		{
+		}
+	};
+
+	FGridlyRateLimiter();
+
+	void DispatchQueuedRequests();
+	bool Tick(float DeltaTime);
+	void Send(const TSharedRef<FQueuedRequest>& QueuedRequest);
+	void OnRequestComplete(FHttpRequestPtr HttpRequestPtr, FHttpResponsePtr HttpResponsePtr, bool bSuccess,
+		TSharedRef<FQueuedRequest> QueuedRequest);
+	void RefillTokens(double Now);
+	double GetRetryDelay(const FHttpResponsePtr& HttpResponsePtr, int32 Attempt) const;
+
+	static FHttpRequestRef CloneRequest(const FHttpRequestRef& HttpRequest);
+
+private:
+	mutable FCriticalSection CriticalSection;
+
+	TArray<TSharedRef<FQueuedRequest>> Queue;
+	TArray<TSharedRef<FQueuedRequest>> InFlight;
+
+	double Rate;
+	double Tokens;
+	double LastRefillTime;
+	double BlockedUntil;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+};
@@ -0,0 +1,215 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#include "GridlySnapshot.h"
+
+#include "Gridly.h"
+#include "GridlyPageFetcher.h"
+#include "HAL/FileManager.h"
+#include "Misc/Crc.h"
+#include "Misc/Paths.h"
+
+static constexpr uint32 GridlySnapshotMagic = 0x47534E50;
+static constexpr int32 GridlySnapshotVersion = 2;
+
+// Written in front of every page, and with INDEX_NONE after the last one
+static constexpr int32 GridlySnapshotEndOfPages = INDEX_NONE;
+
+FArchive& operator<<(FArchive& Ar, FGridlySnapshotHeader& Header)
+{
+	Ar << Header.Magic;
+	Ar << Header.Version;
+	Ar << Header.SchemaHash;
+	Ar << Header.Limit;
+	Ar << Header.TotalCount;
+	Ar << Header.SyncTime;
+	Ar << Header.TrailerOffset;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FGridlySnapshotPage& Page)
+{
+	Ar << Page.Offset;
+	Ar << Page.FileOffset;
+	Ar << Page.ETag;
+	Ar << Page.LastModified;
+	return Ar;
+}
+
+FGridlySnapshotDiff FGridlySnapshotDiff::Compare(const TMap<FString, uint32>& OldRecordHashes,
+	const TMap<FString, uint32>& NewRecordHashes)
+{
+	FGridlySnapshotDiff Diff;
+
+	for (const TPair<FString, uint32>& Pair : NewRecordHashes)
+	{
+		const uint32* OldHash = OldRecordHashes.Find(Pair.Key);
+		if (!OldHash)
+		{
+			Diff.NumAdded++;
+		}
+		else if (*OldHash != Pair.Value)
+		{
+			Diff.NumChanged++;
+		}
+		else
+		{
+			Diff.NumUnchanged++;
+		}
+	}
+
+	Diff.NumRemoved = OldRecordHashes.Num() - Diff.NumChanged - Diff.NumUnchanged;
+
+	return Diff;
+}
+
+TUniquePtr<FGridlySnapshotReader> FGridlySnapshotReader::Open(const FString& Path, uint32 SchemaHash, int32 Limit)
+{
+	TUniquePtr<FArchive> Archive(IFileManager::Get().CreateFileReader(*Path, FILEREAD_Silent));
+	if (!Archive)
+	{
+		return nullptr;
+	}
+
+	FGridlySnapshotHeader Header;
+	*Archive << Header;
+
+	if (Archive->IsError() || Header.Magic != GridlySnapshotMagic || Header.Version != GridlySnapshotVersion
+	    || Header.SchemaHash != SchemaHash || Header.Limit != Limit)
+	{
+		UE_LOG(LogGridly, Log, TEXT("Ignoring outdated snapshot: %s"), *Path);
+		return nullptr;
+	}
+
+	return TUniquePtr<FGridlySnapshotReader>(new FGridlySnapshotReader(MoveTemp(Archive), Header));
+}
+
+FGridlySnapshotReader::FGridlySnapshotReader(TUniquePtr<FArchive>&& InArchive, const FGridlySnapshotHeader& InHeader) :
+	Archive(MoveTemp(InArchive)),
+	Header(InHeader)
+{
+}
+
+bool FGridlySnapshotReader::NextPage(int32& OutOffset)
+{
+	OutOffset = GridlySnapshotEndOfPages;
+	*Archive << OutOffset;
+	return !Archive->IsError() && OutOffset != GridlySnapshotEndOfPages;
+}
+
+bool FGridlySnapshotReader::ReadPage(FGridlyPageData& PageData)
+{
+	PageData.Serialize(*Archive);
+	return !Archive->IsError();
+}
+
+bool FGridlySnapshotReader::ReadTrailer(TMap<FString, uint32>& OutRecordHashes, TArray<FGridlySnapshotPage>& OutPages)
+{
+	Archive->Seek(Header.TrailerOffset);
+	*Archive << OutRecordHashes;
+	*Archive << OutPages;
+	return !Archive->IsError();
+}
+
+bool FGridlySnapshotReader::ReadPageAt(const FGridlySnapshotPage& Page, FGridlyPageData& PageData)
+{
+	Archive->Seek(Page.FileOffset);
+
+	int32 Offset;
+	return NextPage(Offset) && Offset == Page.Offset && ReadPage(PageData);
+}
+
+TUniquePtr<FGridlySnapshotWriter> FGridlySnapshotWriter::Create(const FString& Path, uint32 SchemaHash, int32 Limit,
+	int32 TotalCount)
+{
+	const FString TempPath = Path + TEXT(".tmp");
+
+	TUniquePtr<FArchive> Archive(IFileManager::Get().CreateFileWriter(*TempPath, FILEWRITE_Silent));
+	if (!Archive)
+	{
+		UE_LOG(LogGridly, Warning, TEXT("Unable to write snapshot: %s"), *TempPath);
+		return nullptr;
+	}
+
+	FGridlySnapshotHeader Header;
+	Header.Magic = GridlySnapshotMagic;
+	Header.Version = GridlySnapshotVersion;
+	Header.SchemaHash = SchemaHash;
+	Header.Limit = Limit;
+	Header.TotalCount = TotalCount;
+	Header.SyncTime = FDateTime::UtcNow();
+
+	// The offset of the trailer is patched in once all pages are written
+
+	*Archive << Header;
+
+	return TUniquePtr<FGridlySnapshotWriter>(new FGridlySnapshotWriter(MoveTemp(Archive), Path, TempPath, Header));
+}
+
+FGridlySnapshotWriter::FGridlySnapshotWriter(TUniquePtr<FArchive>&& InArchive, const FString& InPath,
+	const FString& InTempPath, const FGridlySnapshotHeader& InHeader) :
+	Archive(MoveTemp(InArchive)),
+	Path(InPath),
+	TempPath(InTempPath),
+	Header(InHeader)
+{
+}
+
+FGridlySnapshotWriter::~FGridlySnapshotWriter()
+{
+	// Unfinished snapshots are discarded, leaving the previous one in place
+
+	if (Archive)
+	{
+		Archive.Reset();
+		IFileManager::Get().Delete(*TempPath, false, false, true);
+	}
+}
+
+void FGridlySnapshotWriter::WritePage(FGridlyPageData& PageData)
+{
+	FGridlySnapshotPage& Page = Pages.AddDefaulted_GetRef();
+	Page.Offset = PageData.Page.Offset;
+	Page.FileOffset = Archive->Tell();
+	Page.ETag = PageData.ETag;
+	Page.LastModified = PageData.LastModified;
+
+	int32 Offset = PageData.Page.Offset;
+	*Archive << Offset;
+	PageData.Serialize(*Archive);
+	PageData.HashRecords(RecordHashes);
+}
+
+bool FGridlySnapshotWriter::Finish()
+{
+	int32 EndOfPages = GridlySnapshotEndOfPages;
+	*Archive << EndOfPages;
+
+	Header.TrailerOffset = Archive->Tell();
+	*Archive << RecordHashes;
+	*Archive << Pages;
+
+	Archive->Seek(0);
+	*Archive << Header;
+
+	const bool bSuccess = Archive->Close();
+	Archive.Reset();
+
+	if (!bSuccess || !IFileManager::Get().Move(*Path, *TempPath, true, true))
+	{
+		UE_LOG(LogGridly, Warning, TEXT("Unable to write snapshot: %s"), *Path);
+		IFileManager::Get().Delete(*TempPath, false, false, true);
+		return false;
+	}
+
+	return true;
+}
+
+FString FGridlySnapshot::GetSnapshotPath(const FString& Kind, const FString& ViewId)
+{
+	return FPaths::ProjectSavedDir() / TEXT("Gridly") / TEXT("Snapshots") / Kind / FPaths::MakeValidFileName(ViewId) + TEXT(".bin");
+}
+
+uint32 FGridlySnapshot::HashString(const FString& String, uint32 Hash)
+{
+	return FCrc::StrCrc32(*String, Hash);
+}
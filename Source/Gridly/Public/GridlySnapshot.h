@@ -0,0 +1,107 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FGridlyPageData;
+
+/** Header of a view snapshot stored under Saved/Gridly/Snapshots */
+struct GRIDLY_API FGridlySnapshotHeader
+{
+	uint32 Magic = 0;
+	int32 Version = 0;
+	uint32 SchemaHash = 0;
+	int32 Limit = 0;
+	int32 TotalCount = 0;
+	FDateTime SyncTime;
+	int64 TrailerOffset = 0;
+
+	friend FArchive& operator<<(FArchive& Ar, FGridlySnapshotHeader& Header);
+};
+
+/** Location and HTTP validators of a page in a snapshot */
+struct GRIDLY_API FGridlySnapshotPage
+{
+	int32 Offset = 0;
+	int64 FileOffset = 0;
+	FString ETag;
+	FString LastModified;
+
+	friend FArchive& operator<<(FArchive& Ar, FGridlySnapshotPage& Page);
+};
+
+/** Changes between two snapshots of the same view, based on the per-record content hashes */
+struct GRIDLY_API FGridlySnapshotDiff
+{
+	int32 NumAdded = 0;
+	int32 NumChanged = 0;
+	int32 NumRemoved = 0;
+	int32 NumUnchanged = 0;
+
+	static FGridlySnapshotDiff Compare(const TMap<FString, uint32>& OldRecordHashes, const TMap<FString, uint32>& NewRecordHashes);
+};
+
+/** Reads the decoded pages of a view snapshot in offset order */
+class GRIDLY_API FGridlySnapshotReader
+{
+public:
+	/** Returns nullptr if the snapshot is missing, or was written with a different schema or page size */
+	static TUniquePtr<FGridlySnapshotReader> Open(const FString& Path, uint32 SchemaHash, int32 Limit);
+
+	const FGridlySnapshotHeader& GetHeader() const { return Header; }
+
+	/** Moves to the next page and returns its offset. The page is then read with FGridlyPageData::Serialize */
+	bool NextPage(int32& OutOffset);
+	bool ReadPage(FGridlyPageData& PageData);
+
+	/** Reads the record hashes and page table stored after the last page */
+	bool ReadTrailer(TMap<FString, uint32>& OutRecordHashes, TArray<FGridlySnapshotPage>& OutPages);
+
+	/** Reads a single page found in the page table */
+	bool ReadPageAt(const FGridlySnapshotPage& Page, FGridlyPageData& PageData);
+
+	bool HasError() const { return Archive->IsError(); }
+
+private:
+	FGridlySnapshotReader(TUniquePtr<FArchive>&& InArchive, const FGridlySnapshotHeader& InHeader);
+
+private:
+	TUniquePtr<FArchive> Archive;
+	FGridlySnapshotHeader Header;
+};
+
+/** Writes the decoded pages of a view to a temporary file, which replaces the previous snapshot once finished */
+class GRIDLY_API FGridlySnapshotWriter
+{
+public:
+	static TUniquePtr<FGridlySnapshotWriter> Create(const FString& Path, uint32 SchemaHash, int32 Limit, int32 TotalCount);
+	~FGridlySnapshotWriter();
+
+	void WritePage(FGridlyPageData& PageData);
+	bool Finish();
+
+	const TMap<FString, uint32>& GetRecordHashes() const { return RecordHashes; }
+
+private:
+	FGridlySnapshotWriter(TUniquePtr<FArchive>&& InArchive, const FString& InPath, const FString& InTempPath,
+		const FGridlySnapshotHeader& InHeader);
+
+private:
+	TUniquePtr<FArchive> Archive;
+	FString Path;
+	FString TempPath;
+	FGridlySnapshotHeader Header;
+	TMap<FString, uint32> RecordHashes;
+	TArray<FGridlySnapshotPage> Pages;
+};
+
+class GRIDLY_API FGridlySnapshot
+{
+public:
+	/** Location of the snapshot of a view. Kind separates the snapshots of tasks that decode pages differently */
+	static FString GetSnapshotPath(const FString& Kind, const FString& ViewId);
+
+	/** Case-sensitive hash used for record contents and snapshot schemas */
+	static uint32 HashString(const FString& String, uint32 Hash = 0);
+};
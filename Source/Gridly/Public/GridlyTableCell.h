@@ -19,4 +19,9 @@ struct FGridlyTableCell
 
 	UPROPERTY(Category = Gridly, BlueprintReadOnly)
 	FString Value;
+
+	friend FArchive& operator<<(FArchive& Ar, FGridlyTableCell& Cell)
+	{
+		return Ar << Cell.ColumnId << Cell.DependencyStatus << Cell.Value;
+	}
 };
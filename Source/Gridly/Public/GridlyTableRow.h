@@ -21,4 +21,9 @@ struct GRIDLY_API FGridlyTableRow
 
 	UPROPERTY(Category = Gridly, BlueprintReadOnly)
 	TArray<FGridlyTableCell> Cells;
+
+	friend FArchive& operator<<(FArchive& Ar, FGridlyTableRow& Row)
+	{
+		return Ar << Row.Id << Row.Path << Row.Cells;
+	}
 };
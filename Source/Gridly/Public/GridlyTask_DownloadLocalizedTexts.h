@@ -2,8 +2,10 @@
 
 #pragma once
 
+#include "GridlyColumnPlan.h"
+#include "GridlyPageFetcher.h"
 #include "GridlyResult.h"
-#include "Interfaces/IHttpRequest.h"
+#include "GridlyTextSegments.h"
 #include "Internationalization/PolyglotTextData.h"
 #include "Kismet/BlueprintAsyncActionBase.h"
 
@@ -15,6 +17,8 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FDownloadLocalizedTextsDelegate,
 
 DECLARE_DELEGATE_OneParam(FDownloadLocalizedTextsSuccessDelegate, const TArray<FPolyglotTextData>&);
 DECLARE_DELEGATE_TwoParams(FDownloadLocalizedTextsProgressDelegate, const TArray<FPolyglotTextData>&, float);
+DECLARE_DELEGATE_ThreeParams(FDownloadLocalizedTextsPageDelegate, const TArray<FPolyglotTextData>& /*PagePolyglotTextDatas*/, int32 /*NumRecords*/,
+	int32 /*TotalCount*/);
 DECLARE_DELEGATE_TwoParams(FDownloadLocalizedTextsFailDelegate, const TArray<FPolyglotTextData>&, const FGridlyResult&);
 
 UCLASS()
@@ -27,8 +31,15 @@ public:
 
 	virtual void Activate() override;
 
-	void RequestPage(const int ViewIdIndex, const int Offset);
-	void OnProcessRequestComplete(FHttpRequestPtr HttpRequestPtr, FHttpResponsePtr HttpResponsePtr, bool bSuccess);
+	/** Number of records that had the same key as an earlier record, across all pages and views of the last import */
+	int32 GetNumDuplicateRecords() const { return NumDuplicateRecords; }
+
+	/**
+	 * With a memory budget set in the settings, the downloaded texts are kept here instead of being passed to OnSuccess, which
+	 * then receives an empty array. Released by the task once OnSuccess returns, so listeners keep their own reference. Null
+	 * without a budget
+	 */
+	TSharedPtr<FGridlyTextSegments, ESPMode::ThreadSafe> GetTextSegments() const { return TextSegments; }
 
 public:
 	UFUNCTION(Category = Gridly, BlueprintCallable, meta = (BlueprintInternalUseOnly = true, WorldContext = "WorldContextObject"))
@@ -44,20 +55,40 @@ public:
 	UPROPERTY(BlueprintAssignable)
 	FDownloadLocalizedTextsDelegate OnFail;
 
+	/** Called with only the records of each page as it is committed, unlike OnProgress which passes all of them so far */
+	UPROPERTY(BlueprintAssignable)
+	FDownloadLocalizedTextsDelegate OnPage;
+
 	FDownloadLocalizedTextsSuccessDelegate OnSuccessDelegate;
 	FDownloadLocalizedTextsProgressDelegate OnProgressDelegate;
+
+	/** Called with the records of each page, the number of records received so far and the total number of records */
+	FDownloadLocalizedTextsPageDelegate OnPageDelegate;
 	FDownloadLocalizedTextsFailDelegate OnFailDelegate;;
 
 private:
-	FHttpRequestPtr HttpRequest;
-	const UObject* WorldContextObject;
+	TSharedPtr<FGridlyPageData> DecodePage(const FGridlyPageRequest& Page, FHttpResponsePtr HttpResponsePtr);
+	void CommitPage(const TSharedRef<FGridlyPageData>& PageData);
+	void BroadcastPage(const TArray<FPolyglotTextData>& PagePolyglotTextDatas, int32 NumPageRecords);
+	void OnFetchComplete();
+	void OnFetchFail(const FString& Message);
 
-	int Limit;
-	int TotalCount;
+private:
+	TSharedPtr<FGridlyPageFetcher> PageFetcher;
+	const UObject* WorldContextObject;
 
-	TArray<FString> ViewIds;
-	int CurrentViewIdIndex;
-	int CurrentOffset;
+	/** Column roles of each view, indexed like the view IDs and shared by the threads decoding its pages */
+	TArray<TSharedRef<FGridlyColumnPlan, ESPMode::ThreadSafe>> ColumnPlans;
 
 	TArray<FPolyglotTextData> PolyglotTextDatas;
+	int32 NumRecordsReceived;
+
+	/**
+	 * Index of each key in PolyglotTextDatas, or INDEX_NONE for texts added to TextSegments, so duplicates from later pages and
+	 * views are resolved as they are committed
+	 */
+	TMap<FString, int32> RecordIndices;
+	int32 NumDuplicateRecords;
+
+	TSharedPtr<FGridlyTextSegments, ESPMode::ThreadSafe> TextSegments;
 };
@@ -3,9 +3,9 @@
 #pragma once
 
 #include "GridlyDataTable.h"
+#include "GridlyPageFetcher.h"
 #include "GridlyResult.h"
 #include "GridlyTableRow.h"
-#include "Interfaces/IHttpRequest.h"
 #include "Kismet/BlueprintAsyncActionBase.h"
 
 #include "GridlyTask_ImportDataTableFromGridly.generated.h"
@@ -16,6 +16,8 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FImportDataTableFromGridlyDelegat
 
 DECLARE_DELEGATE_OneParam(FImportDataTableFromGridlySuccessDelegate, const TArray<FGridlyTableRow>&);
 DECLARE_DELEGATE_TwoParams(FImportDataTableFromGridlyProgressDelegate, const TArray<FGridlyTableRow>&, float);
+DECLARE_DELEGATE_ThreeParams(FImportDataTableFromGridlyPageDelegate, const TArray<FGridlyTableRow>& /*PageGridlyTableRows*/, int32 /*NumRecords*/,
+	int32 /*TotalCount*/);
 DECLARE_DELEGATE_TwoParams(FImportDataTableFromGridlyFailDelegate, const TArray<FGridlyTableRow>&, const FGridlyResult&);
 
 UCLASS()
@@ -28,8 +30,8 @@ public:
 
 	virtual void Activate() override;
 
-	void RequestPage(const int ViewIdIndex, const int Offset);
-	void OnProcessRequestComplete(FHttpRequestPtr HttpRequestPtr, FHttpResponsePtr HttpResponsePtr, bool bSuccess);
+	/** Number of records that had the same key as an earlier record, across all pages and views of the last import */
+	int32 GetNumDuplicateRecords() const { return NumDuplicateRecords; }
 
 public:
 	UFUNCTION(Category = Gridly, BlueprintCallable, meta = (BlueprintInternalUseOnly = true, WorldContext = "WorldContextObject"))
@@ -46,22 +48,37 @@ public:
 	UPROPERTY(BlueprintAssignable)
 	FImportDataTableFromGridlyDelegate OnFail;
 
+	/** Called with only the records of each page as it is committed, unlike OnProgress which passes all of them so far */
+	UPROPERTY(BlueprintAssignable)
+	FImportDataTableFromGridlyDelegate OnPage;
+
 	FImportDataTableFromGridlySuccessDelegate OnSuccessDelegate;
 	FImportDataTableFromGridlyProgressDelegate OnProgressDelegate;
+
+	/** Called with the records of each page, the number of records received so far and the total number of records */
+	FImportDataTableFromGridlyPageDelegate OnPageDelegate;
 	FImportDataTableFromGridlyFailDelegate OnFailDelegate;;
 
 private:
-	FHttpRequestPtr HttpRequest;
+	TSharedPtr<FGridlyPageData> DecodePage(const FGridlyPageRequest& Page, FHttpResponsePtr HttpResponsePtr);
+	void CommitPage(const TSharedRef<FGridlyPageData>& PageData);
+	void BroadcastPage(const TArray<FGridlyTableRow>& PageGridlyTableRows, int32 NumPageRecords);
+	void OnFetchComplete();
+	void OnFetchFail(const FString& Message);
+
+private:
+	TSharedPtr<FGridlyPageFetcher> PageFetcher;
 	const UObject* WorldContextObject;
 
-	int Limit;
-	int TotalCount;
+	TArray<FGridlyTableRow> GridlyTableRows;
+	int32 NumRecordsReceived;
 
-	TArray<FString> ViewIds;
-	int CurrentViewIdIndex;
-	int CurrentOffset;
+	/** Index of each key in GridlyTableRows, so duplicates from later pages and views are resolved as they are committed */
+	TMap<FString, int32> RecordIndices;
+	int32 NumDuplicateRecords;
 
-	TArray<FGridlyTableRow> GridlyTableRows;
+	/** Columns imported into the row struct, set before the fetch starts and read by the decoding threads. Empty keeps every column */
+	TSet<FString> ImportColumnIds;
 
 	UPROPERTY()
 	UGridlyDataTable* GridlyDataTable;
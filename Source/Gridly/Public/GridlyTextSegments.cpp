@@ -0,0 +1,307 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#include "GridlyTextSegments.h"
+
+#include "Algo/StableSort.h"
+#include "Gridly.h"
+#include "GridlyLocalizedTextConverter.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Guid.h"
+#include "Misc/Paths.h"
+
+static constexpr uint32 GridlySegmentMagic = 0x47534547;
+static constexpr int32 GridlySegmentVersion = 1;
+
+FGridlyTextSegments::FGridlyTextSegments(int64 InMemoryBudget) :
+	MemoryBudget(InMemoryBudget),
+	BufferSize(0),
+	NumTexts(0),
+	bFinished(false),
+	bError(false)
+{
+	DeleteStaleSessions();
+
+	// Named after the owning process, so other processes can tell whether the session is still in use
+
+	SessionDir = GetSegmentsDir() / FString::Printf(TEXT("%u-%s"), FPlatformProcess::GetCurrentProcessId(),
+		*FGuid::NewGuid().ToString(EGuidFormats::Digits));
+}
+
+FGridlyTextSegments::~FGridlyTextSegments()
+{
+	if (SegmentPaths.Num() > 0)
+	{
+		IFileManager::Get().DeleteDirectory(*SessionDir, false, true);
+	}
+}
+
+void FGridlyTextSegments::Add(const FPolyglotTextData& PolyglotTextData)
+{
+	check(!bFinished);
+
+	Buffer.Add(PolyglotTextData);
+	BufferSize += GetAllocatedSize(PolyglotTextData);
+	NumTexts++;
+
+	if (BufferSize > MemoryBudget)
+	{
+		bError |= !SpillBuffer();
+	}
+}
+
+bool FGridlyTextSegments::Finish()
+{
+	check(!bFinished);
+	bFinished = true;
+
+	// Texts that fit the budget are kept in memory, unless they would have to be merged with segments anyway
+
+	if (SegmentPaths.Num() > 0 && Buffer.Num() > 0)
+	{
+		bError |= !SpillBuffer();
+	}
+	else
+	{
+		Algo::StableSort(Buffer, [](const FPolyglotTextData& A, const FPolyglotTextData& B)
+		{
+			return CompareNamespaceAndKey(A, B) < 0;
+		});
+	}
+
+	if (SegmentPaths.Num() > 0)
+	{
+		UE_LOG(LogGridly, Log, TEXT("Spilled %d texts to %d segments"), NumTexts, SegmentPaths.Num());
+	}
+
+	return !bError;
+}
+
+bool FGridlyTextSegments::SpillBuffer()
+{
+	// Sorted before writing, so the segments only need to be merged when read. The sort is stable, keeping texts with the same
+	// namespace and key in the order they were added
+
+	Algo::StableSort(Buffer, [](const FPolyglotTextData& A, const FPolyglotTextData& B)
+	{
+		return CompareNamespaceAndKey(A, B) < 0;
+	});
+
+	const FString SegmentPath = SessionDir / FString::Printf(TEXT("%d.bin"), SegmentPaths.Num());
+
+	const TUniquePtr<FArchive> Archive(IFileManager::Get().CreateFileWriter(*SegmentPath, FILEWRITE_Silent));
+	if (!Archive)
+	{
+		UE_LOG(LogGridly, Error, TEXT("Unable to write text segment: %s"), *SegmentPath);
+		return false;
+	}
+
+	SegmentPaths.Add(SegmentPath);
+
+	uint32 Magic = GridlySegmentMagic;
+	int32 Version = GridlySegmentVersion;
+	int32 NumSegmentTexts = Buffer.Num();
+	*Archive << Magic << Version << NumSegmentTexts;
+
+	for (FPolyglotTextData& PolyglotTextData : Buffer)
+	{
+		FGridlyLocalizedTextConverter::SerializePolyglotTextData(*Archive, PolyglotTextData);
+	}
+
+	Buffer.Reset();
+	BufferSize = 0;
+
+	if (!Archive->Close())
+	{
+		UE_LOG(LogGridly, Error, TEXT("Unable to write text segment: %s"), *SegmentPath);
+		return false;
+	}
+
+	return true;
+}
+
+bool FGridlyTextSegments::ForEachSorted(TFunctionRef<void(const FPolyglotTextData&)> Visitor) const
+{
+	if (!ensure(bFinished) || bError)
+	{
+		return false;
+	}
+
+	if (SegmentPaths.Num() == 0)
+	{
+		for (int32 i = 0; i < Buffer.Num(); i++)
+		{
+			if (i + 1 == Buffer.Num() || CompareNamespaceAndKey(Buffer[i], Buffer[i + 1]) != 0)
+			{
+				Visitor(Buffer[i]);
+			}
+		}
+
+		return true;
+	}
+
+	struct FSegmentReader
+	{
+		TUniquePtr<FArchive> Archive;
+		int32 NumRemaining = 0;
+		FPolyglotTextData Current;
+		bool bHasCurrent = false;
+
+		void Next()
+		{
+			bHasCurrent = NumRemaining > 0 && !Archive->IsError();
+			if (bHasCurrent)
+			{
+				FGridlyLocalizedTextConverter::SerializePolyglotTextData(*Archive, Current);
+				NumRemaining--;
+				bHasCurrent = !Archive->IsError();
+			}
+		}
+	};
+
+	TArray<FSegmentReader> Readers;
+	Readers.SetNum(SegmentPaths.Num());
+
+	for (int32 i = 0; i < SegmentPaths.Num(); i++)
+	{
+		FSegmentReader& Reader = Readers[i];
+		Reader.Archive.Reset(IFileManager::Get().CreateFileReader(*SegmentPaths[i], FILEREAD_Silent));
+		if (!Reader.Archive)
+		{
+			UE_LOG(LogGridly, Error, TEXT("Unable to read text segment: %s"), *SegmentPaths[i]);
+			return false;
+		}
+
+		uint32 Magic = 0;
+		int32 Version = 0;
+		*Reader.Archive << Magic << Version << Reader.NumRemaining;
+
+		if (Reader.Archive->IsError() || Magic != GridlySegmentMagic || Version != GridlySegmentVersion)
+		{
+			UE_LOG(LogGridly, Error, TEXT("Invalid text segment: %s"), *SegmentPaths[i]);
+			return false;
+		}
+
+		Reader.Next();
+	}
+
+	// Segments are few compared to texts, so the smallest head is found with a linear scan. On equal namespaces and keys the
+	// first segment is picked, so later segments and later texts of the same segment replace it in the order they were added
+
+	FPolyglotTextData Selected;
+	while (true)
+	{
+		int32 MinIndex = INDEX_NONE;
+		for (int32 i = 0; i < Readers.Num(); i++)
+		{
+			if (Readers[i].bHasCurrent
+			    && (MinIndex == INDEX_NONE || CompareNamespaceAndKey(Readers[i].Current, Readers[MinIndex].Current) < 0))
+			{
+				MinIndex = i;
+			}
+		}
+
+		if (MinIndex == INDEX_NONE)
+		{
+			break;
+		}
+
+		Selected = MoveTemp(Readers[MinIndex].Current);
+		Readers[MinIndex].Next();
+
+		for (int32 i = MinIndex; i < Readers.Num(); i++)
+		{
+			while (Readers[i].bHasCurrent && CompareNamespaceAndKey(Readers[i].Current, Selected) == 0)
+			{
+				Selected = MoveTemp(Readers[i].Current);
+				Readers[i].Next();
+			}
+		}
+
+		Visitor(Selected);
+	}
+
+	for (int32 i = 0; i < Readers.Num(); i++)
+	{
+		if (Readers[i].Archive->IsError() || Readers[i].NumRemaining > 0)
+		{
+			UE_LOG(LogGridly, Error, TEXT("Failed to read text segment: %s"), *SegmentPaths[i]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+FString FGridlyTextSegments::GetSegmentsDir()
+{
+	return FPaths::ProjectSavedDir() / TEXT("Gridly") / TEXT("Segments");
+}
+
+void FGridlyTextSegments::DeleteStaleSessions()
+{
+	// Sessions of processes that are no longer running were left by a crashed or cancelled import. Sessions of this process
+	// are deleted by their owner. Entries without an owning process are only deleted once they are old enough to be unused
+
+	const uint32 CurrentProcessId = FPlatformProcess::GetCurrentProcessId();
+	const FDateTime StaleTime = FDateTime::UtcNow() - FTimespan::FromDays(1);
+
+	TArray<FString> StaleDirs;
+	TArray<FString> StaleFiles;
+	IFileManager::Get().IterateDirectory(*GetSegmentsDir(),
+		[CurrentProcessId, &StaleTime, &StaleDirs, &StaleFiles](const TCHAR* Path, bool bIsDirectory)
+		{
+			FString ProcessId;
+			if (bIsDirectory && FPaths::GetCleanFilename(Path).Split(TEXT("-"), &ProcessId, nullptr) && ProcessId.IsNumeric())
+			{
+				const uint32 OwnerProcessId = FCString::Strtoui64(*ProcessId, nullptr, 10);
+				if (OwnerProcessId != CurrentProcessId && !FPlatformProcess::IsApplicationRunning(OwnerProcessId))
+				{
+					StaleDirs.Add(Path);
+				}
+			}
+			else if (IFileManager::Get().GetTimeStamp(Path) < StaleTime)
+			{
+				(bIsDirectory ? StaleDirs : StaleFiles).Add(Path);
+			}
+
+			return true;
+		});
+
+	for (const FString& StaleDir : StaleDirs)
+	{
+		IFileManager::Get().DeleteDirectory(*StaleDir, false, true);
+	}
+
+	for (const FString& StaleFile : StaleFiles)
+	{
+		IFileManager::Get().Delete(*StaleFile, false, false, true);
+	}
+
+	if (StaleDirs.Num() + StaleFiles.Num() > 0)
+	{
+		UE_LOG(LogGridly, Log, TEXT("Deleted %d stale text segment entries"), StaleDirs.Num() + StaleFiles.Num());
+	}
+}
+
+int64 FGridlyTextSegments::GetAllocatedSize(const FPolyglotTextData& PolyglotTextData)
+{
+	int64 Size = sizeof(FPolyglotTextData) + PolyglotTextData.GetNamespace().GetAllocatedSize()
+	             + PolyglotTextData.GetKey().GetAllocatedSize() + PolyglotTextData.GetNativeString().GetAllocatedSize()
+	             + PolyglotTextData.GetNativeCulture().GetAllocatedSize();
+
+	FString LocalizedString;
+	for (const FString& Culture : PolyglotTextData.GetLocalizedCultures())
+	{
+		PolyglotTextData.GetLocalizedString(Culture, LocalizedString);
+		Size += sizeof(FString) * 2 + Culture.GetAllocatedSize() + LocalizedString.GetAllocatedSize();
+	}
+
+	return Size;
+}
+
+int32 FGridlyTextSegments::CompareNamespaceAndKey(const FPolyglotTextData& A, const FPolyglotTextData& B)
+{
+	const int32 Result = A.GetNamespace().Compare(B.GetNamespace(), ESearchCase::CaseSensitive);
+	return Result != 0 ? Result : A.GetKey().Compare(B.GetKey(), ESearchCase::CaseSensitive);
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Internationalization/PolyglotTextData.h"
+
+/**
+ * Downloaded texts held within a memory budget. Texts are buffered in memory, and each time the buffer grows over the budget
+ * it is sorted and spilled to a segment file under Saved/Gridly/Segments/<Session>. Readers stream the texts back in namespace
+ * and key order by merging the segments, so only one text per segment is in memory at a time.
+ *
+ * The session directory is named after the owning process and deleted along with the segments. Sessions left behind by a
+ * process that is no longer running are deleted when new segments are created.
+ */
+class GRIDLY_API FGridlyTextSegments
+{
+public:
+	/** Budget in bytes of the buffered texts */
+	explicit FGridlyTextSegments(int64 InMemoryBudget);
+	~FGridlyTextSegments();
+
+	FGridlyTextSegments(const FGridlyTextSegments&) = delete;
+	FGridlyTextSegments& operator=(const FGridlyTextSegments&) = delete;
+
+	void Add(const FPolyglotTextData& PolyglotTextData);
+
+	/** Called once every text is added. Texts still buffered are spilled too if any segment was written */
+	bool Finish();
+
+	/** Number of texts added, including those with the same namespace and key */
+	int32 Num() const { return NumTexts; }
+	int32 GetNumSegments() const { return SegmentPaths.Num(); }
+
+	/**
+	 * Visits every text in namespace and key order. Of texts added with the same namespace and key, only the last one added
+	 * is visited. Once finished, any number of threads can read the segments at the same time
+	 */
+	bool ForEachSorted(TFunctionRef<void(const FPolyglotTextData&)> Visitor) const;
+
+private:
+	bool SpillBuffer();
+
+	static FString GetSegmentsDir();
+	static void DeleteStaleSessions();
+
+	static int64 GetAllocatedSize(const FPolyglotTextData& PolyglotTextData);
+	static int32 CompareNamespaceAndKey(const FPolyglotTextData& A, const FPolyglotTextData& B);
+
+private:
+	int64 MemoryBudget;
+
+	TArray<FPolyglotTextData> Buffer;
+	int64 BufferSize;
+
+	FString SessionDir;
+	TArray<FString> SegmentPaths;
+	int32 NumTexts;
+	bool bFinished;
+	bool bError;
+};
@@ -0,0 +1,129 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#include "GridlyUploadWindow.h"
+
+#include "Gridly.h"
+#include "GridlyRateLimiter.h"
+#include "Interfaces/IHttpResponse.h"
+
+FGridlyUploadWindow::FGridlyUploadWindow(int32 InNumChunks, int32 InMaxConcurrentRequests, int32 InMaxRetries) :
+	NumChunks(FMath::Max(0, InNumChunks)),
+	MaxConcurrentRequests(FMath::Max(1, InMaxConcurrentRequests)),
+	MaxRetries(FMath::Max(0, InMaxRetries)),
+	NextChunkIndex(0),
+	NumWaitingRetries(0),
+	NumCompletedChunks(0),
+	bCancelled(false)
+{
+}
+
+void FGridlyUploadWindow::Start()
+{
+	DispatchRequests();
+}
+
+void FGridlyUploadWindow::Cancel()
+{
+	bCancelled = true;
+
+	const TArray<FHttpRequestPtr> Requests = InFlightRequests;
+	InFlightRequests.Reset();
+	for (const FHttpRequestPtr& Request : Requests)
+	{
+		FGridlyRateLimiter::Get().CancelRequest(Request);
+	}
+}
+
+void FGridlyUploadWindow::DispatchRequests()
+{
+	// Chunks waiting for a retry do not hold a slot, so the other chunks keep uploading meanwhile
+
+	while (!bCancelled && InFlightRequests.Num() < MaxConcurrentRequests)
+	{
+		int32 ChunkIndex;
+		if (RetryChunkIndices.Num() > 0)
+		{
+			ChunkIndex = RetryChunkIndices[0];
+			RetryChunkIndices.RemoveAt(0);
+		}
+		else if (NextChunkIndex < NumChunks)
+		{
+			ChunkIndex = NextChunkIndex++;
+		}
+		else
+		{
+			break;
+		}
+
+		const FHttpRequestPtr HttpRequest = OnCreateRequest.IsBound() ? OnCreateRequest.Execute(ChunkIndex) : nullptr;
+		if (!HttpRequest.IsValid())
+		{
+			CompleteChunk(ChunkIndex, nullptr, nullptr, false);
+			continue;
+		}
+
+		HttpRequest->OnProcessRequestComplete().BindSP(this, &FGridlyUploadWindow::OnRequestComplete, ChunkIndex);
+		InFlightRequests.Add(HttpRequest);
+
+		FGridlyRateLimiter::Get().ProcessRequest(HttpRequest.ToSharedRef());
+	}
+}
+
+void FGridlyUploadWindow::OnRequestComplete(FHttpRequestPtr HttpRequestPtr, FHttpResponsePtr HttpResponsePtr, bool bSuccess,
+	int32 ChunkIndex)
+{
+	InFlightRequests.Remove(HttpRequestPtr);
+
+	if (bCancelled)
+	{
+		return;
+	}
+
+	const int32 ResponseCode = HttpResponsePtr.IsValid() ? HttpResponsePtr->GetResponseCode() : 0;
+	const bool bAccepted = bSuccess && (ResponseCode == EHttpResponseCodes::Ok || ResponseCode == EHttpResponseCodes::Created);
+
+	// Client errors, such as a wrong API key or a malformed chunk, fail the same way every time
+
+	const bool bRetryable = !bSuccess || ResponseCode >= 500 || ResponseCode == EHttpResponseCodes::RequestTimeout;
+
+	int32& NumRetries = ChunkRetries.FindOrAdd(ChunkIndex);
+	if (!bAccepted && bRetryable && NumRetries < MaxRetries)
+	{
+		NumRetries++;
+
+		const float Delay = FMath::Min(static_cast<float>(1 << FMath::Min(NumRetries - 1, 5)), 30.f);
+		UE_LOG(LogGridly, Warning, TEXT("Upload of chunk %d failed (%d), retrying in %.0f seconds (%d of %d)"), ChunkIndex,
+			ResponseCode, Delay, NumRetries, MaxRetries);
+
+		NumWaitingRetries++;
+		FTSTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateSP(this, &FGridlyUploadWindow::OnRetryDelayElapsed, ChunkIndex), Delay);
+	}
+	else
+	{
+		CompleteChunk(ChunkIndex, HttpRequestPtr, HttpResponsePtr, bSuccess);
+	}
+
+	DispatchRequests();
+}
+
+bool FGridlyUploadWindow::OnRetryDelayElapsed(float DeltaTime, int32 ChunkIndex)
+{
+	if (!bCancelled)
+	{
+		NumWaitingRetries--;
+		RetryChunkIndices.Add(ChunkIndex);
+		DispatchRequests();
+	}
+
+	return false;
+}
+
+void FGridlyUploadWindow::CompleteChunk(int32 ChunkIndex, FHttpRequestPtr HttpRequestPtr, FHttpResponsePtr HttpResponsePtr,
+	bool bSuccess)
+{
+	// Counted before the delegate runs, so it can tell whether this was the last chunk
+
+	NumCompletedChunks++;
+	OnChunkComplete.ExecuteIfBound(ChunkIndex, HttpRequestPtr, HttpResponsePtr, bSuccess);
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Containers/Ticker.h"
+#include "Interfaces/IHttpRequest.h"
+
+DECLARE_DELEGATE_RetVal_OneParam(FHttpRequestPtr, FGridlyCreateUploadRequestDelegate, int32 /*ChunkIndex*/);
+DECLARE_DELEGATE_FourParams(FGridlyUploadChunkCompleteDelegate, int32 /*ChunkIndex*/, FHttpRequestPtr, FHttpResponsePtr,
+	bool /*bSuccess*/);
+
+/**
+ * Uploads a number of chunks through a window of concurrent requests. The request of a chunk is only created once a slot is
+ * free, so chunks waiting their turn hold no payload. A chunk whose request fails is retried with a growing delay, while
+ * the other chunks keep uploading in the meantime.
+ */
+class GRIDLY_API FGridlyUploadWindow : public TSharedFromThis<FGridlyUploadWindow>
+{
+public:
+	FGridlyUploadWindow(int32 InNumChunks, int32 InMaxConcurrentRequests, int32 InMaxRetries);
+
+	void Start();
+	void Cancel();
+
+	int32 GetNumChunks() const { return NumChunks; }
+
+	/** Chunks that were accepted or have run out of retries */
+	int32 GetNumCompletedChunks() const { return NumCompletedChunks; }
+	bool IsComplete() const { return GetNumCompletedChunks() >= NumChunks; }
+
+public:
+	/** Creates the request of a chunk, each time it is sent. Returning nullptr fails the chunk */
+	FGridlyCreateUploadRequestDelegate OnCreateRequest;
+
+	/** Called once for each chunk, when it is accepted with 200 or 201, or when its last attempt has failed */
+	FGridlyUploadChunkCompleteDelegate OnChunkComplete;
+
+private:
+	void DispatchRequests();
+	void OnRequestComplete(FHttpRequestPtr HttpRequestPtr, FHttpResponsePtr HttpResponsePtr, bool bSuccess, int32 ChunkIndex);
+	bool OnRetryDelayElapsed(float DeltaTime, int32 ChunkIndex);
+	void CompleteChunk(int32 ChunkIndex, FHttpRequestPtr HttpRequestPtr, FHttpResponsePtr HttpResponsePtr, bool bSuccess);
+
+private:
+	int32 NumChunks;
+	int32 MaxConcurrentRequests;
+	int32 MaxRetries;
+
+	int32 NextChunkIndex;
+
+	/** Chunks whose retry delay has elapsed, sent before any new chunk */
+	TArray<int32> RetryChunkIndices;
+	TMap<int32, int32> ChunkRetries;
+	int32 NumWaitingRetries;
+
+	TArray<FHttpRequestPtr> InFlightRequests;
+	/** Requests complete on the game thread, so the count is never shared with another thread */
+	int32 NumCompletedChunks;
+	bool bCancelled;
+};
@@ -8,6 +8,8 @@
 #include "GridlyEditor.h"
 #include "GridlyExporter.h"
 #include "GridlyGameSettings.h"
+#include "GridlyHttp.h"
+#include "GridlyRateLimiter.h"
 #include "GridlyStyle.h"
 #include "GridlyTableRow.h"
 #include "GridlyTask_ImportDataTableFromGridly.h"
@@ -292,10 +294,11 @@ void FAssetTypeActions_GridlyDataTable::ImportFromGridly(UGridlyDataTable* DataT
 
 	FDataTableEditorUtils::BroadcastPreChange(GridlyDataTable, FDataTableEditorUtils::EDataTableChangeInfo::RowList);
 
-	Task->OnProgressDelegate.BindLambda(
-		[GridlyDataTable, &SlowTask](const TArray<FGridlyTableRow>& GridlyTableRows, float Progress) mutable
+	Task->OnPageDelegate.BindLambda(
+		[GridlyDataTable, &SlowTask](const TArray<FGridlyTableRow>& PageGridlyTableRows, int32 NumRecords, int32 TotalCount) mutable
 		{
-			const float Delta = Progress - SlowTask->CompletedWork;
+			const float Progress = static_cast<float>(NumRecords) / static_cast<float>(FMath::Max(1, TotalCount));
+			const float Delta = FMath::Max(0.f, Progress - SlowTask->CompletedWork);
 			SlowTask->EnterProgressFrame(Delta);
 		});
 
@@ -334,15 +337,12 @@ bool CreateExportRequest(const UGridlyDataTable* GridlyDataTable,
 
 		FStringFormatNamedArguments Args;
 		Args.Add(TEXT("ViewId"), *ViewId);
-		const FString Url = FString::Format(TEXT("https://api.gridly.com/v1/views/{ViewId}/records"), Args);
+		const FString Url = FGridlyHttp::GetApiUrl(FString::Format(TEXT("/v1/views/{ViewId}/records"), Args));
 
-		const auto HttpRequest = FHttpModule::Get().CreateRequest();
+		const auto HttpRequest = FGridlyHttp::CreateRequest(TEXT("POST"), Url, ApiKey);
 		HttpRequest->SetHeader(TEXT("Accept"), TEXT("application/json"));
 		HttpRequest->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
-		HttpRequest->SetHeader(TEXT("Authorization"), FString::Printf(TEXT("ApiKey %s"), *ApiKey));
-		HttpRequest->SetContentAsString(JsonString);
-		HttpRequest->SetVerb(TEXT("POST"));
-		HttpRequest->SetURL(Url);
+		FGridlyHttp::SetContentAsString(HttpRequest, JsonString);
 
 		ExportRequest = HttpRequest;
 
@@ -367,61 +367,85 @@ void FAssetTypeActions_GridlyDataTable::ExportToGridly(UGridlyDataTable* DataTab
 	UGridlyDataTable* GridlyDataTable = Cast<UGridlyDataTable>(DataTable);
 	check(GridlyDataTable);
 
-	TSharedPtr<FScopedSlowTask, ESPMode::ThreadSafe> ExportDataTableToGridlySlowTask = MakeShareable(new FScopedSlowTask(
-		1.f,
-		LOCTEXT("ExportGridlyDataTableSlowTask", "Exporting data table to Gridly")));
+	const UGridlyGameSettings* GameSettings = GetDefault<UGridlyGameSettings>();
+	const int32 ChunkSize = FMath::Max(1, GameSettings->ExportMaxRecordsPerRequest);
+	const int32 TotalRequests = GridlyDataTable->RowStruct
+		                            ? FMath::DivideAndRoundUp(GridlyDataTable->GetRowMap().Num(), ChunkSize)
+		                            : 0;
 
-
-	size_t TotalRequests = 0;
-	size_t StartIndex = 0;
-	TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> HttpRequest;
-	while (CreateExportRequest(GridlyDataTable, StartIndex, HttpRequest))
+	if (ExportUploadWindow.IsValid())
 	{
-		HttpRequest->OnProcessRequestComplete().
-		             BindLambda([this, ExportDataTableToGridlySlowTask](FHttpRequestPtr HttpRequest,
-			             FHttpResponsePtr HttpResponse, bool bSuccess) mutable
-			             {
-				             if (bSuccess
-				                 && (HttpResponse->GetResponseCode() == EHttpResponseCodes::Ok ||
-				                     HttpResponse->GetResponseCode() == EHttpResponseCodes::Created))
-				             {
-					             ExportDataTableToGridlySlowTask->EnterProgressFrame(1.f);
-
-					             TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> NextHttpRequest;
-					             if (this->ExportRequestQueue.Dequeue(NextHttpRequest))
-					             {
-						             NextHttpRequest->ProcessRequest();
-					             }
-					             else
-					             {
-						             ExportDataTableToGridlySlowTask.Reset();
-					             }
-				             }
-				             else
-				             {
-					             ExportDataTableToGridlySlowTask.Reset();
-					             const FString Content = HttpResponse->GetContentAsString();
-					             const FString ErrorReason =
-						             FString::Printf(TEXT("Error: %d, reason: %s"), HttpResponse->GetResponseCode(), *Content);
-					             UE_LOG(LogGridlyEditor, Error, TEXT("%s"), *ErrorReason);
-					             FMessageDialog::Open(EAppMsgType::Ok, FText::FromString(ErrorReason));
-				             }
-			             });
-		ExportRequestQueue.Enqueue(HttpRequest);
-		StartIndex += GetMutableDefault<UGridlyGameSettings>()->ExportMaxRecordsPerRequest;
-		TotalRequests++;
+		ExportUploadWindow->Cancel();
+		ExportUploadWindow.Reset();
 	}
 
-	if (ExportRequestQueue.Dequeue(HttpRequest))
+	if (TotalRequests == 0)
 	{
-		ExportDataTableToGridlySlowTask->TotalAmountOfWork = static_cast<float>(TotalRequests);
-		ExportDataTableToGridlySlowTask->MakeDialog();
-		HttpRequest->ProcessRequest();
+		return;
 	}
-	else
+
+	TSharedPtr<FScopedSlowTask, ESPMode::ThreadSafe> ExportDataTableToGridlySlowTask = MakeShareable(new FScopedSlowTask(
+		static_cast<float>(TotalRequests),
+		LOCTEXT("ExportGridlyDataTableSlowTask", "Exporting data table to Gridly")));
+	ExportDataTableToGridlySlowTask->MakeDialog();
+
+	// Chunks are serialized as the upload window frees a slot for them, and a failed chunk is retried by the window first
+
+	const TSharedRef<FGridlyUploadWindow> UploadWindow = MakeShared<FGridlyUploadWindow>(TotalRequests,
+		GameSettings->ExportMaxConcurrentRequests, GameSettings->ExportMaxChunkRetries);
+	ExportUploadWindow = UploadWindow;
+
+	const TWeakObjectPtr<UGridlyDataTable> WeakDataTable(GridlyDataTable);
+	UploadWindow->OnCreateRequest.BindLambda([WeakDataTable, ChunkSize](int32 ChunkIndex) -> FHttpRequestPtr
 	{
-		ExportDataTableToGridlySlowTask.Reset();
-	}
+		TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> HttpRequest;
+		if (!WeakDataTable.IsValid() || !CreateExportRequest(WeakDataTable.Get(), ChunkIndex * ChunkSize, HttpRequest))
+		{
+			return nullptr;
+		}
+
+		return HttpRequest;
+	});
+
+	const TWeakPtr<FGridlyUploadWindow> WeakUploadWindow(UploadWindow);
+	UploadWindow->OnChunkComplete.BindLambda([WeakUploadWindow, ExportDataTableToGridlySlowTask](int32 ChunkIndex,
+		FHttpRequestPtr HttpRequest, FHttpResponsePtr HttpResponse, bool bSuccess) mutable
+	{
+		const int32 ResponseCode = HttpResponse.IsValid() ? HttpResponse->GetResponseCode() : 0;
+		if (bSuccess && (ResponseCode == EHttpResponseCodes::Ok || ResponseCode == EHttpResponseCodes::Created))
+		{
+			if (ExportDataTableToGridlySlowTask.IsValid())
+			{
+				ExportDataTableToGridlySlowTask->EnterProgressFrame(1.f);
+			}
+
+			const TSharedPtr<FGridlyUploadWindow> Window = WeakUploadWindow.Pin();
+			if (Window.IsValid() && Window->IsComplete())
+			{
+				ExportDataTableToGridlySlowTask.Reset();
+			}
+		}
+		else
+		{
+			ExportDataTableToGridlySlowTask.Reset();
+
+			// The other chunks are dropped, the export is reported as failed once
+
+			if (const TSharedPtr<FGridlyUploadWindow> Window = WeakUploadWindow.Pin())
+			{
+				Window->Cancel();
+			}
+
+			const FString ErrorReason = HttpResponse.IsValid()
+				                            ? FString::Printf(TEXT("Error: %d, reason: %s"), ResponseCode,
+					                            *FGridlyHttp::GetContentAsString(HttpResponse))
+				                            : FString::Printf(TEXT("Error: unable to export chunk %d to Gridly"), ChunkIndex);
+			UE_LOG(LogGridlyEditor, Error, TEXT("%s"), *ErrorReason);
+			FMessageDialog::Open(EAppMsgType::Ok, FText::FromString(ErrorReason));
+		}
+	});
+
+	UploadWindow->Start();
 }
 
 void FAssetTypeActions_GridlyDataTable::AddToolbarButton(FToolBarBuilder& Builder)
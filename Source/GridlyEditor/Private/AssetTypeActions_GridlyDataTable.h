@@ -3,6 +3,7 @@
 #include "AssetTypeActions_CSVAssetBase.h"
 #include "AssetDefinitionDefault.h"
 #include "GridlyDataTable.h"
+#include "GridlyUploadWindow.h"
 #include "Interfaces/IHttpRequest.h"
 
 
@@ -30,6 +31,6 @@ private:
 	void ExportToGridly(UGridlyDataTable* DataTable);
 	void AddToolbarButton(FToolBarBuilder& Builder);
 
-	TQueue<TSharedPtr<IHttpRequest, ESPMode::ThreadSafe>> ExportRequestQueue;
+	TSharedPtr<FGridlyUploadWindow> ExportUploadWindow;
 	static TMap<uint32, TSharedPtr<FScopedSlowTask, ESPMode::ThreadSafe>> ImportSlowTasks;
 };
@@ -0,0 +1,196 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#include "GridlyExportManifest.h"
+
+#include "GridlyEditor.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+static constexpr uint32 GridlyExportManifestMagic = 0x47454D46;
+static constexpr int32 GridlyExportManifestVersion = 1;
+
+FGridlyExportManifest::FGridlyExportManifest(const FString& ViewId) :
+	Path(FPaths::ProjectSavedDir() / TEXT("Gridly") / TEXT("ExportManifests") / FPaths::MakeValidFileName(ViewId) + TEXT(".bin"))
+{
+}
+
+bool FGridlyExportManifest::Load()
+{
+	ColumnIds.Reset();
+	ColumnIndices.Reset();
+	Records.Reset();
+
+	const TUniquePtr<FArchive> Archive(IFileManager::Get().CreateFileReader(*Path, FILEREAD_Silent));
+	if (!Archive)
+	{
+		return false;
+	}
+
+	uint32 Magic = 0;
+	int32 Version = 0;
+	*Archive << Magic << Version;
+
+	if (Archive->IsError() || Magic != GridlyExportManifestMagic || Version != GridlyExportManifestVersion)
+	{
+		UE_LOG(LogGridlyEditor, Warning, TEXT("Ignoring invalid export manifest: %s"), *Path);
+		return false;
+	}
+
+	*Archive << ColumnIds;
+
+	int32 NumRecords = 0;
+	*Archive << NumRecords;
+	Records.Reserve(FMath::Max(0, NumRecords));
+
+	for (int32 i = 0; i < NumRecords && !Archive->IsError(); i++)
+	{
+		FString RecordId;
+		int32 NumCells = 0;
+		*Archive << RecordId << NumCells;
+
+		TArray<FCellHash>& Cells = Records.Add(MoveTemp(RecordId));
+		Cells.SetNum(FMath::Clamp(NumCells, 0, ColumnIds.Num()));
+		for (FCellHash& Cell : Cells)
+		{
+			*Archive << Cell.ColumnIndex << Cell.Hash;
+		}
+	}
+
+	// A damaged manifest would skip cells that were never exported, so it is safer to start over
+
+	bool bValid = !Archive->IsError();
+	for (const TPair<FString, TArray<FCellHash>>& Record : Records)
+	{
+		for (const FCellHash& Cell : Record.Value)
+		{
+			bValid &= ColumnIds.IsValidIndex(Cell.ColumnIndex);
+		}
+	}
+
+	if (!bValid)
+	{
+		UE_LOG(LogGridlyEditor, Warning, TEXT("Ignoring damaged export manifest: %s"), *Path);
+		ColumnIds.Reset();
+		Records.Reset();
+		return false;
+	}
+
+	for (int32 i = 0; i < ColumnIds.Num(); i++)
+	{
+		ColumnIndices.Add(ColumnIds[i], i);
+	}
+
+	UE_LOG(LogGridlyEditor, Log, TEXT("Loaded export manifest of %d records: %s"), Records.Num(), *Path);
+	return true;
+}
+
+bool FGridlyExportManifest::Save()
+{
+	const FString TempPath = Path + TEXT(".tmp");
+
+	{
+		const TUniquePtr<FArchive> Archive(IFileManager::Get().CreateFileWriter(*TempPath, FILEWRITE_Silent));
+		if (!Archive)
+		{
+			UE_LOG(LogGridlyEditor, Error, TEXT("Unable to write export manifest: %s"), *TempPath);
+			return false;
+		}
+
+		uint32 Magic = GridlyExportManifestMagic;
+		int32 Version = GridlyExportManifestVersion;
+		*Archive << Magic << Version;
+		*Archive << ColumnIds;
+
+		int32 NumRecords = Records.Num();
+		*Archive << NumRecords;
+
+		for (TPair<FString, TArray<FCellHash>>& Record : Records)
+		{
+			int32 NumCells = Record.Value.Num();
+			*Archive << Record.Key << NumCells;
+
+			for (FCellHash& Cell : Record.Value)
+			{
+				*Archive << Cell.ColumnIndex << Cell.Hash;
+			}
+		}
+
+		if (!Archive->Close())
+		{
+			UE_LOG(LogGridlyEditor, Error, TEXT("Unable to write export manifest: %s"), *TempPath);
+			IFileManager::Get().Delete(*TempPath, false, false, true);
+			return false;
+		}
+	}
+
+	// The manifest of the last export stays in place until the new one is complete
+
+	if (!IFileManager::Get().Move(*Path, *TempPath, true, true, false, true))
+	{
+		UE_LOG(LogGridlyEditor, Error, TEXT("Unable to replace export manifest: %s"), *Path);
+		IFileManager::Get().Delete(*TempPath, false, false, true);
+		return false;
+	}
+
+	return true;
+}
+
+uint32 FGridlyExportManifest::HashCell(const FString& Value, EGridlyColumnDataType DataType)
+{
+	return HashCombine(FCrc::StrCrc32(*Value), static_cast<uint32>(DataType));
+}
+
+bool FGridlyExportManifest::IsCellUnchanged(const FString& RecordId, const FString& ColumnId, uint32 Hash) const
+{
+	const TArray<FCellHash>* Cells = Records.Find(RecordId);
+	const int32* ColumnIndex = ColumnIndices.Find(ColumnId);
+	if (!Cells || !ColumnIndex)
+	{
+		return false;
+	}
+
+	const FCellHash* Cell = Cells->FindByPredicate([ColumnIndex](const FCellHash& Candidate)
+	{
+		return Candidate.ColumnIndex == *ColumnIndex;
+	});
+
+	return Cell && Cell->Hash == Hash;
+}
+
+void FGridlyExportManifest::SetCell(const FString& RecordId, const FString& ColumnId, uint32 Hash)
+{
+	int32 ColumnIndex;
+	if (const int32* ExistingIndex = ColumnIndices.Find(ColumnId))
+	{
+		ColumnIndex = *ExistingIndex;
+	}
+	else
+	{
+		ColumnIndex = ColumnIds.Add(ColumnId);
+		ColumnIndices.Add(ColumnId, ColumnIndex);
+	}
+
+	TArray<FCellHash>& Cells = Records.FindOrAdd(RecordId);
+	if (FCellHash* Cell = Cells.FindByPredicate([ColumnIndex](const FCellHash& Candidate)
+	{
+		return Candidate.ColumnIndex == ColumnIndex;
+	}))
+	{
+		Cell->Hash = Hash;
+	}
+	else
+	{
+		Cells.Add(FCellHash{ColumnIndex, Hash});
+	}
+}
+
+void FGridlyExportManifest::RetainRecords(const TSet<FString>& RecordIds)
+{
+	for (auto It = Records.CreateIterator(); It; ++It)
+	{
+		if (!RecordIds.Contains(It.Key()))
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
@@ -0,0 +1,50 @@
+// Copyright (c) 2021 LocalizeDirect AB
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "GridlyGameSettings.h"
+
+/**
+ * Content hashes of the cells exported to a view, keyed by record ID and column, stored under Saved/Gridly/ExportManifests.
+ * A delta export compares the cells of each record against it and only sends what changed since the last export.
+ *
+ * Hashes are only recorded for chunks Gridly has accepted, and the file is replaced once the export ends, so after a failed
+ * or interrupted export the cells that were not accepted are sent again.
+ */
+class FGridlyExportManifest
+{
+public:
+	explicit FGridlyExportManifest(const FString& ViewId);
+
+	/** Reads the manifest of the last export to the view. Returns false and starts empty if there is none or it is invalid */
+	bool Load();
+	bool Save();
+
+	static uint32 HashCell(const FString& Value, EGridlyColumnDataType DataType);
+
+	bool HasRecord(const FString& RecordId) const { return Records.Contains(RecordId); }
+	bool IsCellUnchanged(const FString& RecordId, const FString& ColumnId, uint32 Hash) const;
+	void SetCell(const FString& RecordId, const FString& ColumnId, uint32 Hash);
+
+	/** Forgets records that are not exported anymore, so they are sent in full if they come back */
+	void RetainRecords(const TSet<FString>& RecordIds);
+
+	int32 Num() const { return Records.Num(); }
+
+private:
+	struct FCellHash
+	{
+		int32 ColumnIndex;
+		uint32 Hash;
+	};
+
+	FString Path;
+
+	/** Column IDs are shared by every record, so each record only stores their indices */
+	TArray<FString> ColumnIds;
+	TMap<FString, int32> ColumnIndices;
+
+	TMap<FString, TArray<FCellHash>> Records;
+};
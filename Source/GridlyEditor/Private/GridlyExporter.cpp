@@ -3,168 +3,217 @@
 #include "GridlyCultureConverter.h"
 #include "GridlyDataTableImporterJSON.h"
 #include "GridlyGameSettings.h"
-#include "Dom/JsonObject.h"
-#include "Dom/JsonValue.h"
+#include "GridlyLocalizedText.h"
 #include "Internationalization/PolyglotTextData.h"
 #include "LocTextHelper.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
+#include "Serialization/JsonWriter.h"
 
-bool FGridlyExporter::ConvertToJson(const TArray<FPolyglotTextData>& PolyglotTextDatas,
-	bool bIncludeTargetTranslations, const TSharedPtr<FLocTextHelper>& LocTextHelperPtr, FString& OutJsonString)
+FGridlyExportSchema::FGridlyExportSchema(bool bInIncludeTargetTranslations) :
+	bIncludeTargetTranslations(bInIncludeTargetTranslations)
 {
-	UGridlyGameSettings* GameSettings = GetMutableDefault<UGridlyGameSettings>();
-	const TArray<FString> TargetCultures = FGridlyCultureConverter::GetTargetCultures();
+	const UGridlyGameSettings* GameSettings = GetDefault<UGridlyGameSettings>();
 
-	const bool bUseCombinedNamespaceKey = GameSettings->bUseCombinedNamespaceId;
-	const bool bExportNamespace = !bUseCombinedNamespaceKey || GameSettings->bAlsoExportNamespaceColumn;
-	const bool bUsePathAsNamespace = GameSettings->NamespaceColumnId == "path";
+	bUseCombinedNamespaceKey = GameSettings->bUseCombinedNamespaceId;
+	bExportNamespace = !bUseCombinedNamespaceKey || GameSettings->bAlsoExportNamespaceColumn;
+	bUsePathAsNamespace = GameSettings->NamespaceColumnId == "path";
+	NamespaceColumnId = GameSettings->NamespaceColumnId;
+	bExportNamespace &= bUsePathAsNamespace || !NamespaceColumnId.IsEmpty();
 
-	TArray<TSharedPtr<FJsonValue>> Rows;
+	// Cultures without a Gridly culture are never exported, so they are left out here
 
-	for (int i = 0; i < PolyglotTextDatas.Num(); i++)
+	for (const FString& Culture : FGridlyCultureConverter::GetTargetCultures())
 	{
-		TSharedPtr<FJsonObject> RowJsonObject = MakeShareable(new FJsonObject);
-		TArray<TSharedPtr<FJsonValue>> CellsJsonArray;
-
-		const FString& Key = PolyglotTextDatas[i].GetKey();
-		const FString& Namespace = PolyglotTextDatas[i].GetNamespace();
-
-		const FManifestContext* ItemContext = nullptr;
-		if (LocTextHelperPtr.IsValid())
+		FString GridlyCulture;
+		if (FGridlyCultureConverter::ConvertToGridly(Culture, GridlyCulture))
 		{
-			TSharedPtr<FManifestEntry> ManifestEntry = LocTextHelperPtr->FindSourceText(Namespace, Key);
-			ItemContext = ManifestEntry ? ManifestEntry->FindContextByKey(Key) : nullptr;
+			SourceColumnIds.Add(Culture, GameSettings->SourceLanguageColumnIdPrefix + GridlyCulture);
+			TargetColumns.Add(FCultureColumn{Culture, GameSettings->TargetLanguageColumnIdPrefix + GridlyCulture});
 		}
+	}
 
-		// Set record id
+	bExportContext = GameSettings->bExportContext;
+	ContextColumnId = GameSettings->ContextColumnId;
 
-		if (bUseCombinedNamespaceKey)
-		{
-			// Use Contains method to check for the substring "blueprints/"
-			if (Namespace.Contains(TEXT("blueprints/"))) {
-				RowJsonObject->SetStringField("id", FString::Printf(TEXT("%s,%s"), TEXT(""), *Key));
-			}
-			else {
-				RowJsonObject->SetStringField("id", FString::Printf(TEXT("%s,%s"), *Namespace, *Key));
-			}
-		}
+	bExportMetadata = GameSettings->bExportMetadata;
+	if (bExportMetadata)
+	{
+		MetadataColumns = GameSettings->MetadataMapping;
+	}
+}
+
+void FGridlyExportSchema::GetRecordId(const FPolyglotTextData& PolyglotTextData, FString& OutRecordId) const
+{
+	const FString& Key = PolyglotTextData.GetKey();
+	const FString& Namespace = PolyglotTextData.GetNamespace();
 
-		else
+	OutRecordId.Reset();
+
+	if (bUseCombinedNamespaceKey)
+	{
+		// Blueprint texts are exported with an empty namespace in their ID
+		if (!Namespace.Contains(TEXT("blueprints/")))
 		{
-			RowJsonObject->SetStringField("id", Key);
+			OutRecordId.Append(Namespace);
 		}
 
-		// Set namespace/path
+		OutRecordId.AppendChar(TEXT(','));
+	}
+
+	OutRecordId.Append(Key);
+}
+
+const FString* FGridlyExportSchema::FindSourceColumnId(const FString& NativeCulture, FString& OutColumnId) const
+{
+	if (const FString* ColumnId = SourceColumnIds.Find(NativeCulture))
+	{
+		return ColumnId;
+	}
+
+	FString GridlyCulture;
+	if (FGridlyCultureConverter::ConvertToGridly(NativeCulture, GridlyCulture))
+	{
+		OutColumnId = GetDefault<UGridlyGameSettings>()->SourceLanguageColumnIdPrefix + GridlyCulture;
+		return &OutColumnId;
+	}
+
+	return nullptr;
+}
+
+void FGridlyExportSchema::ForEachCell(const FGridlyExportText& ExportText,
+	TFunctionRef<void(const FGridlyExportCell&)> Visitor) const
+{
+	const FPolyglotTextData& PolyglotTextData = ExportText.PolyglotTextData;
+
+	// Set namespace/path
+
+	if (bExportNamespace)
+	{
+		Visitor(FGridlyExportCell{NamespaceColumnId, PolyglotTextData.GetNamespace(), EGridlyColumnDataType::String,
+			bUsePathAsNamespace});
+	}
+
+	// Set source language text
 
-		if (bExportNamespace)
+	const FString& NativeCulture = PolyglotTextData.GetNativeCulture();
+
+	FString ColumnIdBuffer;
+	if (const FString* SourceColumnId = FindSourceColumnId(NativeCulture, ColumnIdBuffer))
+	{
+		Visitor(FGridlyExportCell{*SourceColumnId, PolyglotTextData.GetNativeString()});
+	}
+
+	// Add context
+
+	if (bExportContext)
+	{
+		FString Context = ExportText.SourceLocation;
+		Context.ReplaceInline(TEXT(" - line "), TEXT(":"), ESearchCase::CaseSensitive);
+		Visitor(FGridlyExportCell{ContextColumnId, Context});
+	}
+
+	// Add metadata
+
+	if (bExportMetadata && ExportText.InfoMetadata.IsValid())
+	{
+		for (const auto& InfoMetaDataPair : ExportText.InfoMetadata->Values)
 		{
-			if (bUsePathAsNamespace)
+			if (const FGridlyColumnInfo* GridlyColumnInfo = MetadataColumns.Find(InfoMetaDataPair.Key))
 			{
-				RowJsonObject->SetStringField("path", Namespace);
+				Visitor(FGridlyExportCell{GridlyColumnInfo->Name, InfoMetaDataPair.Value->ToString(), GridlyColumnInfo->DataType});
 			}
-			else if (!GameSettings->NamespaceColumnId.IsEmpty())
+		}
+	}
+
+	if (bIncludeTargetTranslations)
+	{
+		FString LocalizedString;
+		for (const FCultureColumn& TargetColumn : TargetColumns)
+		{
+			if (TargetColumn.Culture != NativeCulture && PolyglotTextData.GetLocalizedString(TargetColumn.Culture, LocalizedString))
 			{
-				TSharedPtr<FJsonObject> CellJsonObject = MakeShareable(new FJsonObject);
-				CellJsonObject->SetStringField("columnId", GameSettings->NamespaceColumnId);
-				CellJsonObject->SetStringField("value", Namespace);
-				CellsJsonArray.Add(MakeShareable(new FJsonValueObject(CellJsonObject)));
+				Visitor(FGridlyExportCell{TargetColumn.ColumnId, LocalizedString});
 			}
 		}
+	}
+}
 
-		// Set source language text
+bool FGridlyExporter::ConvertToJson(TArrayView<const FGridlyExportText> ExportTexts, const FGridlyExportSchema& ExportSchema,
+	FString& OutJsonString)
+{
+	// Written in the same order and with the same policy as serializing a JSON object per record did, so the output is
+	// unchanged
 
-		{
-			const FString NativeCulture = PolyglotTextDatas[i].GetNativeCulture();
-			const FString NativeString = PolyglotTextDatas[i].GetNativeString();
+	const TSharedRef<TJsonWriter<>> JsonWriter = TJsonStringWriter<>::Create(&OutJsonString);
+	JsonWriter->WriteArrayStart();
 
-			FString GridlyCulture;
-			if (FGridlyCultureConverter::ConvertToGridly(NativeCulture, GridlyCulture))
-			{
-				TSharedPtr<FJsonObject> CellJsonObject = MakeShareable(new FJsonObject);
-				CellJsonObject->SetStringField("columnId", GameSettings->SourceLanguageColumnIdPrefix + GridlyCulture);
-				CellJsonObject->SetStringField("value", NativeString);
-				CellsJsonArray.Add(MakeShareable(new FJsonValueObject(CellJsonObject)));
-			}
+	FString RecordId;
+	for (const FGridlyExportText& ExportText : ExportTexts)
+	{
+		JsonWriter->WriteObjectStart();
 
-			// Add context
+		// Set record id
 
-			if (ItemContext && GameSettings->bExportContext)
-			{				
-				TSharedPtr<FJsonObject> CellJsonObject = MakeShareable(new FJsonObject);
-				CellJsonObject->SetStringField("columnId", *GameSettings->ContextColumnId);
-				CellJsonObject->SetStringField("value",
-					ItemContext->SourceLocation.Replace(TEXT(" - line "), TEXT(":"), ESearchCase::CaseSensitive));
-				CellsJsonArray.Add(MakeShareable(new FJsonValueObject(CellJsonObject)));
-			}
+		ExportSchema.GetRecordId(ExportText.PolyglotTextData, RecordId);
+		JsonWriter->WriteValue(TEXT("id"), RecordId);
 
-			// Add metadata
+		// The path is visited first, so it is written as a field of the record before the cells array is started. A delta
+		// export only sends the cells that changed since the last export
 
- 			if (ItemContext && GameSettings->bExportMetadata && ItemContext->InfoMetadataObj.IsValid())
+		bool bCellsStarted = false;
+		ExportSchema.ForEachCell(ExportText, [&JsonWriter, &ExportText, &bCellsStarted](const FGridlyExportCell& Cell)
+		{
+			if (ExportText.ExportColumnIds.Num() > 0 && !ExportText.ExportColumnIds.Contains(Cell.ColumnId))
 			{
-				for (const auto& InfoMetaDataPair : ItemContext->InfoMetadataObj->Values)
-				{
-					const FString& KeyName = InfoMetaDataPair.Key;
-					if (const FGridlyColumnInfo* GridlyColumnInfo = GameSettings->MetadataMapping.Find(InfoMetaDataPair.Key))
-					{
-						TSharedPtr<FJsonObject> CellJsonObject = MakeShareable(new FJsonObject);
-						CellJsonObject->SetStringField("columnId", *GridlyColumnInfo->Name);
-
-						const TSharedPtr<FLocMetadataValue> Value = InfoMetaDataPair.Value;
+				return;
+			}
 
-						switch (GridlyColumnInfo->DataType)
-						{
-							case EGridlyColumnDataType::String:
-							{
-								CellJsonObject->SetStringField("value", Value->ToString());
-							}
-							break;
-							case EGridlyColumnDataType::Number:
-							{
-								CellJsonObject->SetNumberField("value", FCString::Atoi(*Value->ToString()));
-							}
-							break;
-							default:
-								break;
-						}
+			if (Cell.bIsPath)
+			{
+				JsonWriter->WriteValue(TEXT("path"), Cell.Value);
+				return;
+			}
 
-						CellsJsonArray.Add(MakeShareable(new FJsonValueObject(CellJsonObject)));
-					}
-				}
+			if (!bCellsStarted)
+			{
+				JsonWriter->WriteArrayStart(TEXT("cells"));
+				bCellsStarted = true;
 			}
 
-			if (bIncludeTargetTranslations)
+			JsonWriter->WriteObjectStart();
+			JsonWriter->WriteValue(TEXT("columnId"), Cell.ColumnId);
+
+			switch (Cell.DataType)
 			{
-				for (int j = 0; j < TargetCultures.Num(); j++)
+				case EGridlyColumnDataType::String:
 				{
-					const FString CultureName = TargetCultures[j];
-					FString LocalizedString;
-
-					if (CultureName != NativeCulture
-					    && PolyglotTextDatas[i].GetLocalizedString(CultureName, LocalizedString)
-					    && FGridlyCultureConverter::ConvertToGridly(CultureName, GridlyCulture))
-					{
-						TSharedPtr<FJsonObject> CellJsonObject = MakeShareable(new FJsonObject);
-						CellJsonObject->SetStringField("columnId", GameSettings->TargetLanguageColumnIdPrefix + GridlyCulture);
-						CellJsonObject->SetStringField("value", LocalizedString);
-						CellsJsonArray.Add(MakeShareable(new FJsonValueObject(CellJsonObject)));
-					}
+					JsonWriter->WriteValue(TEXT("value"), Cell.Value);
 				}
+				break;
+				case EGridlyColumnDataType::Number:
+				{
+					// Numbers were stored as doubles in the JSON value
+					JsonWriter->WriteValue(TEXT("value"), static_cast<double>(FCString::Atoi(*Cell.Value)));
+				}
+				break;
+				default:
+					break;
 			}
-		}
-
-		// Assign array
 
-		RowJsonObject->SetArrayField("cells", CellsJsonArray);
+			JsonWriter->WriteObjectEnd();
+		});
 
-		Rows.Add(MakeShareable(new FJsonValueObject(RowJsonObject)));
-	}
+		if (!bCellsStarted)
+		{
+			JsonWriter->WriteArrayStart(TEXT("cells"));
+		}
 
-	const TSharedRef<TJsonWriter<>> JsonWriter = TJsonStringWriter<>::Create(&OutJsonString);
-	if (FJsonSerializer::Serialize(Rows, JsonWriter))
-	{
-		return true;
+		JsonWriter->WriteArrayEnd();
+		JsonWriter->WriteObjectEnd();
 	}
 
-	return false;
+	JsonWriter->WriteArrayEnd();
+	return JsonWriter->Close();
 }
 
 bool FGridlyExporter::ConvertToJson(const UGridlyDataTable* GridlyDataTable, FString& OutJsonString, size_t StartIndex,
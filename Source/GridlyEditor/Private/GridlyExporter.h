@@ -3,13 +3,67 @@
 #pragma once
 
 #include "GridlyDataTable.h"
+#include "GridlyGameSettings.h"
 
-class FLocTextHelper;
+struct FGridlyExportText;
+
+/** A value of an exported record. The path is a field of the record rather than a cell, but it is exported and tracked like one */
+struct FGridlyExportCell
+{
+	const FString& ColumnId;
+	const FString& Value;
+	EGridlyColumnDataType DataType = EGridlyColumnDataType::String;
+	bool bIsPath = false;
+};
+
+/**
+ * The columns of an export, resolved from the settings and target cultures once per export rather than for every record:
+ * the column ID of each culture, the namespace and context columns, and the columns metadata is bound to
+ */
+class FGridlyExportSchema
+{
+public:
+	explicit FGridlyExportSchema(bool bInIncludeTargetTranslations);
+
+	/** Reuses the allocation of OutRecordId, so a caller going through many records only allocates for the longest ID */
+	void GetRecordId(const FPolyglotTextData& PolyglotTextData, FString& OutRecordId) const;
+
+	/** Visits the cells of a record in the order they are exported */
+	void ForEachCell(const FGridlyExportText& ExportText, TFunctionRef<void(const FGridlyExportCell&)> Visitor) const;
+
+private:
+	struct FCultureColumn
+	{
+		FString Culture;
+		FString ColumnId;
+	};
+
+	const FString* FindSourceColumnId(const FString& NativeCulture, FString& OutColumnId) const;
+
+private:
+	bool bUseCombinedNamespaceKey;
+	bool bIncludeTargetTranslations;
+
+	bool bExportNamespace;
+	bool bUsePathAsNamespace;
+	FString NamespaceColumnId;
+
+	/** Source columns of the target cultures, any other native culture is resolved when it is met */
+	TMap<FString, FString> SourceColumnIds;
+	TArray<FCultureColumn> TargetColumns;
+
+	bool bExportContext;
+	FString ContextColumnId;
+
+	bool bExportMetadata;
+	TMap<FString, FGridlyColumnInfo> MetadataColumns;
+};
 
 class FGridlyExporter
 {
 public:
-	static bool ConvertToJson(const TArray<FPolyglotTextData>& PolyglotTextDatas, bool bIncludeTargetTranslations,
-		const TSharedPtr<FLocTextHelper>& LocTextHelperPtr, FString& OutJsonString);
+	/** Writes the records straight to JSON, without building a JSON object for each record and cell first */
+	static bool ConvertToJson(TArrayView<const FGridlyExportText> ExportTexts, const FGridlyExportSchema& ExportSchema,
+		FString& OutJsonString);
 	static bool ConvertToJson(const UGridlyDataTable* GridlyDataTable, FString& OutJsonString, size_t StartIndex, size_t MaxSize);
 };
@@ -1,6 +1,8 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "GridlyImportExportCommandlet.h"
+#include "GridlyGameSettings.h"
+#include "GridlyLocalizedTextConverter.h"
 #include "GridlyLocalizationServiceProvider.h"
 #include "Modules/ModuleManager.h"
 #include "ILocalizationServiceModule.h"
@@ -10,6 +12,7 @@
 #include "HttpModule.h"
 #include "HttpManager.h"
 #include "LocalizationConfigurationScript.h"
+#include "Containers/Ticker.h"
 
 #include "UObject/UObjectGlobals.h"
 #include "UObject/Package.h"
@@ -19,6 +22,19 @@ DEFINE_LOG_CATEGORY_STATIC(LogGridlyImportExportCommandlet, Log, All);
 
 #define LOCTEXT_NAMESPACE "GridlyImportExportCommandlet"
 
+/** The engine loop isn't running in a commandlet, so both HTTP requests and delayed dispatches need to be ticked by hand */
+static void TickPendingRequests()
+{
+	static double LastTickTime = FPlatformTime::Seconds();
+
+	FPlatformProcess::Sleep(0.4f);
+	FHttpModule::Get().GetHttpManager().Tick(-1.f);
+
+	const double CurrentTime = FPlatformTime::Seconds();
+	FTSTicker::GetCoreTicker().Tick(static_cast<float>(CurrentTime - LastTickTime));
+	LastTickTime = CurrentTime;
+}
+
 /**
 *	UGridlyImportExportCommandlet
 */
@@ -80,6 +96,13 @@ int32 UGridlyImportExportCommandlet::Main(const FString& Params)
 		return -1;
 	}
 
+	// -ForceFullExport sends every record, regardless of the manifest of the last export
+
+	if (Switches.Contains(TEXT("ForceFullExport")))
+	{
+		GetMutableDefault<UGridlyGameSettings>()->bForceFullExport = true;
+	}
+
 	const TArray<ULocalizationTarget*> LocalizationTargets = ULocalizationSettings::GetGameTargetSet()->TargetObjects;
 	//ULocalizationTarget* FirstLocTarget = LocalizationTargets.Num() > 0 ? LocalizationTargets[0]: nullptr;
 	for (ULocalizationTarget* LocTarget : LocalizationTargets)
@@ -125,8 +148,7 @@ int32 UGridlyImportExportCommandlet::Main(const FString& Params)
 				// Wait for all downloads
 				while (CulturesToDownload.Num())
 				{
-					FPlatformProcess::Sleep(0.4f);
-					FHttpModule::Get().GetHttpManager().Tick(-1.f);
+					TickPendingRequests();
 				}
 
 				// Run task to import po files, it will be done on the base folder and import all po files data generated after downloading data from gridly
@@ -139,27 +161,47 @@ int32 UGridlyImportExportCommandlet::Main(const FString& Params)
 					const FString DirectoryPath = FPaths::GetPath(DlPoFile);
 					const FString DownloadBasePath = FPaths::GetPath(DirectoryPath);
 
-					// Create commandlet task to Import texts
-					// Note that we could simply "Import all PO files" using a call to PortableObjectPipeline::ImportAll(...), though
-					//		using tasks we are able to easily add/remove call to existing localization functionalities
-					TArray<LocalizationCommandletExecution::FTask> Tasks;
-					const bool ShouldUseProjectFile = !Target->IsMemberOfEngineTargetSet();
-
-					const FString ImportScriptPath = LocalizationConfigurationScript::GetImportTextConfigPath(Target, TOptional<FString>());
-					LocalizationConfigurationScript::GenerateImportTextConfigFile(Target, TOptional<FString>(), DownloadBasePath).WriteWithSCC(ImportScriptPath);
-					Tasks.Add(LocalizationCommandletExecution::FTask(LOCTEXT("ImportTaskName", "Import Translations"), ImportScriptPath, ShouldUseProjectFile));
-
-					const FString ReportScriptPath = LocalizationConfigurationScript::GetWordCountReportConfigPath(Target);
-					LocalizationConfigurationScript::GenerateWordCountReportConfigFile(Target).WriteWithSCC(ReportScriptPath);
-					Tasks.Add(LocalizationCommandletExecution::FTask(LOCTEXT("ReportTaskName", "Generate Reports"), ReportScriptPath, ShouldUseProjectFile));
+					// The archives are updated in this process when possible, which saves booting an editor for each task
+					bool bImported = false;
+					if (GridlyProvider->ImportDownloadedCulturesInProcess(Target, DownloadedCultures))
+					{
+						UE_LOG(LogGridlyImportExportCommandlet, Log, TEXT("Imported %d cultures in process"), DownloadedCultures.Num());
+						bImported = true;
+					}
+					else
+					{
+						// Create commandlet task to Import texts
+						// Note that we could simply "Import all PO files" using a call to PortableObjectPipeline::ImportAll(...), though
+						//		using tasks we are able to easily add/remove call to existing localization functionalities
+						TArray<LocalizationCommandletExecution::FTask> Tasks;
+						const bool ShouldUseProjectFile = !Target->IsMemberOfEngineTargetSet();
+
+						const FString ImportScriptPath = LocalizationConfigurationScript::GetImportTextConfigPath(Target, TOptional<FString>());
+						LocalizationConfigurationScript::GenerateImportTextConfigFile(Target, TOptional<FString>(), DownloadBasePath).WriteWithSCC(ImportScriptPath);
+						Tasks.Add(LocalizationCommandletExecution::FTask(LOCTEXT("ImportTaskName", "Import Translations"), ImportScriptPath, ShouldUseProjectFile));
+
+						const FString ReportScriptPath = LocalizationConfigurationScript::GetWordCountReportConfigPath(Target);
+						LocalizationConfigurationScript::GenerateWordCountReportConfigFile(Target).WriteWithSCC(ReportScriptPath);
+						Tasks.Add(LocalizationCommandletExecution::FTask(LOCTEXT("ReportTaskName", "Generate Reports"), ReportScriptPath, ShouldUseProjectFile));
+
+						// Function will block until all tasks have been run
+						bImported = BlockingRunLocCommandletTask(Tasks);
+					}
 
-					// Function will block until all tasks have been run
-					BlockingRunLocCommandletTask(Tasks);
+					// Files are only skipped as unchanged once they are imported, so a failed import is done again next time
+					if (bImported)
+					{
+						for (const FString& DownloadedFile : DownloadedFiles)
+						{
+							FGridlyLocalizedTextConverter::CommitPoFileHash(DownloadedFile);
+						}
+					}
 				}
 
 				// Cleanup
 				CulturesToDownload.Empty();
 				DownloadedFiles.Empty();
+				DownloadedCultures.Empty();
 			}
 
 			if (bDoExport)
@@ -172,8 +214,7 @@ int32 UGridlyImportExportCommandlet::Main(const FString& Params)
 				// Wait for Http requests
 				while (GridlyProvider->HasRequestsPending())
 				{
-					FPlatformProcess::Sleep(0.4f);
-					FHttpModule::Get().GetHttpManager().Tick(-1.f);
+					TickPendingRequests();
 				}
 			}
 		}
@@ -196,6 +237,9 @@ void UGridlyImportExportCommandlet::OnDownloadComplete(const FLocalizationServic
 	{
 		const FText ErrorMessage = DownloadLocalizationTargetOp->GetOutErrorText();
 		UE_LOG(LogGridlyImportExportCommandlet, Error, TEXT("%s"), *ErrorMessage.ToString());
+
+		// The file of a failed download is stale or empty, so it is not imported
+		return;
 	}
 
 	const FString TargetName = FPaths::GetBaseFilename(DownloadLocalizationTargetOp->GetInRelativeOutputFilePathAndName());
@@ -204,11 +248,25 @@ void UGridlyImportExportCommandlet::OnDownloadComplete(const FLocalizationServic
 	const FString AbsoluteFilePathAndName = FPaths::ConvertRelativePathToFull(
 		FPaths::ProjectDir() / DownloadLocalizationTargetOp->GetInRelativeOutputFilePathAndName());
 
+	// Files left untouched since the last import do not need to be imported again
+
+	const FGridlyLocalizationServiceProvider& GridlyProvider = static_cast<FGridlyLocalizationServiceProvider&>(
+		ILocalizationServiceModule::Get().GetProvider());
+	if (Result == ELocalizationServiceOperationCommandResult::Succeeded
+	    && GridlyProvider.IsDownloadUnchanged(DownloadLocalizationTargetOp.ToSharedRef()))
+	{
+		UE_LOG(LogGridlyImportExportCommandlet, Log, TEXT("Unchanged since the last import: %s"), *AbsoluteFilePathAndName);
+		return;
+	}
+
 	DownloadedFiles.Add(AbsoluteFilePathAndName);
+	DownloadedCultures.Add(DownloadLocalizationTargetOp->GetInLocale());
 }
 
-void UGridlyImportExportCommandlet::BlockingRunLocCommandletTask(const TArray<LocalizationCommandletExecution::FTask>& Tasks)
+bool UGridlyImportExportCommandlet::BlockingRunLocCommandletTask(const TArray<LocalizationCommandletExecution::FTask>& Tasks)
 {
+	bool bAllSucceeded = true;
+
 	for (const LocalizationCommandletExecution::FTask& LocTask : Tasks)
 	{
 		TSharedPtr<FLocalizationCommandletProcess> CommandletProcess = FLocalizationCommandletProcess::Execute(LocTask.ScriptPath, LocTask.ShouldUseProjectFile);
@@ -246,12 +304,17 @@ void UGridlyImportExportCommandlet::BlockingRunLocCommandletTask(const TArray<Lo
 			{
 				UE_LOG(LogGridlyImportExportCommandlet, Log, TEXT("===> Task [%s] returned : %d"), *LocTask.Name.ToString(), ReturnCode);
 			}
+
+			bAllSucceeded &= ReturnCode == 0;
 		}
 		else
 		{
 			UE_LOG(LogGridlyImportExportCommandlet, Warning, TEXT("Failed to start Task [%s] !"), *LocTask.Name.ToString());
+			bAllSucceeded = false;
 		}
 	}
+
+	return bAllSucceeded;
 }
 
 #undef LOCTEXT_NAMESPACE
\ No newline at end of file
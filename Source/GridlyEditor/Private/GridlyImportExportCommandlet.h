@@ -29,8 +29,9 @@ public:
 private:
 	TArray<FString> CulturesToDownload;
 	TArray<FString> DownloadedFiles;
+	TArray<FString> DownloadedCultures;
 
 private:
 	void OnDownloadComplete(const FLocalizationServiceOperationRef& Operation, ELocalizationServiceOperationCommandResult::Type Result, bool bIsTargetSet);
-	void BlockingRunLocCommandletTask(const TArray<LocalizationCommandletExecution::FTask>& LocTasks);
+	bool BlockingRunLocCommandletTask(const TArray<LocalizationCommandletExecution::FTask>& LocTasks);
 };
\ No newline at end of file
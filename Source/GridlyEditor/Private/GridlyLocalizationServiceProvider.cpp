@@ -3,8 +3,11 @@
 #include "GridlyLocalizationServiceProvider.h"
 
 #include "GridlyEditor.h"
+#include "GridlyCultureConverter.h"
 #include "GridlyExporter.h"
 #include "GridlyGameSettings.h"
+#include "GridlyHttp.h"
+#include "GridlyRateLimiter.h"
 #include "GridlyLocalizedText.h"
 #include "GridlyLocalizedTextConverter.h"
 #include "GridlyStyle.h"
@@ -13,7 +16,9 @@
 #include "ILocalizationServiceModule.h"
 #include "LocalizationCommandletTasks.h"
 #include "LocalizationModule.h"
+#include "LocalizationSettings.h"
 #include "LocalizationTargetTypes.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
 #include "Interfaces/IHttpResponse.h"
 #include "Interfaces/IMainFrameModule.h"
 #include "Internationalization/Culture.h"
@@ -125,48 +130,125 @@ ELocalizationServiceOperationCommandResult::Type FGridlyLocalizationServiceProvi
 {
 	const TSharedRef<FDownloadLocalizationTargetFile, ESPMode::ThreadSafe> DownloadOperation =
 		StaticCastSharedRef<FDownloadLocalizationTargetFile>(InOperation);
-	const FString TargetCulture = DownloadOperation->GetInLocale();
 
-	UGridlyTask_DownloadLocalizedTexts* Task = UGridlyTask_DownloadLocalizedTexts::DownloadLocalizedTexts(nullptr);
+	// The views hold the columns of every culture, so all download operations issued while a download is in progress are
+	// served from that same download
 
-	// On success
-	Task->OnSuccessDelegate.BindLambda(
-		[this, DownloadOperation, InOperationCompleteDelegate, TargetCulture](const TArray<FPolyglotTextData>& PolyglotTextDatas)
+	const bool bStartDownload = !ImportSession.IsValid();
+	if (bStartDownload)
+	{
+		ImportSession = MakeShared<FGridlyImportSession>();
+	}
+
+	ImportSession->PendingOperations.Add(FGridlyPendingDownload{DownloadOperation, InOperationCompleteDelegate});
+
+	if (bStartDownload)
+	{
+		UGridlyTask_DownloadLocalizedTexts* Task = UGridlyTask_DownloadLocalizedTexts::DownloadLocalizedTexts(nullptr);
+
+		// On success, the texts are either passed along or, with a memory budget, kept in the task's segments
+		Task->OnSuccessDelegate.BindLambda([this, Task](const TArray<FPolyglotTextData>& PolyglotTextDatas)
 		{
-			/*
-			if (PolyglotTextDatas.Num() > 0)
-			{
-			*/
-			const FString AbsoluteFilePathAndName = FPaths::ConvertRelativePathToFull(
-				FPaths::ProjectDir() / DownloadOperation->GetInRelativeOutputFilePathAndName());
+			OnImportSessionDownloaded(PolyglotTextDatas, Task->GetTextSegments());
+		});
 
-			bool writeProc = FGridlyLocalizedTextConverter::WritePoFile(PolyglotTextDatas, TargetCulture, AbsoluteFilePathAndName);
-			// Callback for successful write
-			InOperationCompleteDelegate.Execute(DownloadOperation, ELocalizationServiceOperationCommandResult::Succeeded);
-			/*
+		// On fail
+		Task->OnFailDelegate.BindRaw(this, &FGridlyLocalizationServiceProvider::OnImportSessionFailed);
+
+		// Activate the task
+		Task->Activate();
+	}
+
+	return ELocalizationServiceOperationCommandResult::Succeeded;
+}
+
+void FGridlyLocalizationServiceProvider::OnImportSessionDownloaded(const TArray<FPolyglotTextData>& PolyglotTextDatas,
+	const TSharedPtr<FGridlyTextSegments, ESPMode::ThreadSafe>& TextSegments)
+{
+	const TSharedPtr<FGridlyImportSession> Session = MoveTemp(ImportSession);
+	check(Session.IsValid());
+
+	UE_LOG(LogGridlyEditor, Log, TEXT("Downloaded %d texts, writing %d cultures"),
+		TextSegments ? TextSegments->Num() : PolyglotTextDatas.Num(), Session->PendingOperations.Num());
+
+	// Kept for the in-process import, which applies the texts without reading back the .po files. Segments are shared
+	// rather than copied
+
+	if (GetMutableDefault<UGridlyGameSettings>()->bImportInProcess)
+	{
+		if (TextSegments)
+		{
+			DownloadedTextSegments = TextSegments;
+		}
+		else
+		{
+			DownloadedPolyglotTextDatas = PolyglotTextDatas;
+		}
+	}
+
+	TArray<FGridlyPoFile> PoFiles;
+	for (const FGridlyPendingDownload& PendingDownload : Session->PendingOperations)
+	{
+		FGridlyPoFile& PoFile = PoFiles.AddDefaulted_GetRef();
+		PoFile.Culture = PendingDownload.Operation->GetInLocale();
+		PoFile.Path = FPaths::ConvertRelativePathToFull(
+			FPaths::ProjectDir() / PendingDownload.Operation->GetInRelativeOutputFilePathAndName());
+	}
+
+	// All cultures are written on worker threads, each operation completes here as soon as its file is flushed
+
+	const bool bSkipUnchanged = GetMutableDefault<UGridlyGameSettings>()->bSkipUnchangedCultures;
+	const FGridlyPoFileWrittenDelegate OnPoFileWritten = FGridlyPoFileWrittenDelegate::CreateLambda(
+		[this, &Session, &PoFiles](int32 Index, bool bSuccess, bool bChanged)
+		{
+			const FGridlyPendingDownload& PendingDownload = Session->PendingOperations[Index];
+
+			if (bChanged)
+			{
+				UnchangedDownloads.Remove(PoFiles[Index].Path);
 			}
 			else
 			{
-				// Handle parse failure
-				DownloadOperation->SetOutErrorText(LOCTEXT("GridlyErrorParse", "Failed to parse downloaded content"));
-				InOperationCompleteDelegate.Execute(DownloadOperation, ELocalizationServiceOperationCommandResult::Failed);
+				UnchangedDownloads.Add(PoFiles[Index].Path);
 			}
-			*/
-		});
 
-	// On fail
-	Task->OnFailDelegate.BindLambda(
-		[DownloadOperation, InOperationCompleteDelegate](const TArray<FPolyglotTextData>& PolyglotTextDatas, const FGridlyResult& Error)
-		{
-			// Handle download failure
-			DownloadOperation->SetOutErrorText(FText::FromString(Error.Message));
-			InOperationCompleteDelegate.Execute(DownloadOperation, ELocalizationServiceOperationCommandResult::Failed);
+			// A failed write leaves a stale or empty file, which must not be imported
+
+			if (!bSuccess)
+			{
+				PendingDownload.Operation->SetOutErrorText(FText::Format(
+					LOCTEXT("GridlyPoFileWriteError", "ERROR: Unable to write .po file: {0}"), FText::FromString(PoFiles[Index].Path)));
+				PendingDownload.OnComplete.ExecuteIfBound(PendingDownload.Operation, ELocalizationServiceOperationCommandResult::Failed);
+				return;
+			}
+
+			// Callback for successful write
+			PendingDownload.OnComplete.ExecuteIfBound(PendingDownload.Operation,
+				ELocalizationServiceOperationCommandResult::Succeeded);
 		});
 
-	// Activate the task
-	Task->Activate();
+	if (TextSegments)
+	{
+		FGridlyLocalizedTextConverter::WritePoFiles(*TextSegments, PoFiles, bSkipUnchanged, OnPoFileWritten);
+	}
+	else
+	{
+		FGridlyLocalizedTextConverter::WritePoFiles(PolyglotTextDatas, PoFiles, bSkipUnchanged, OnPoFileWritten);
+	}
+}
 
-	return ELocalizationServiceOperationCommandResult::Succeeded;
+void FGridlyLocalizationServiceProvider::OnImportSessionFailed(const TArray<FPolyglotTextData>& PolyglotTextDatas,
+	const FGridlyResult& Error)
+{
+	const TSharedPtr<FGridlyImportSession> Session = MoveTemp(ImportSession);
+	check(Session.IsValid());
+
+	// Handle download failure
+	for (const FGridlyPendingDownload& PendingDownload : Session->PendingOperations)
+	{
+		PendingDownload.Operation->SetOutErrorText(FText::FromString(Error.Message));
+		PendingDownload.OnComplete.ExecuteIfBound(PendingDownload.Operation, ELocalizationServiceOperationCommandResult::Failed);
+	}
 }
 
 
@@ -277,6 +359,8 @@ void FGridlyLocalizationServiceProvider::ImportAllCulturesForTargetFromGridly(
 
 		CurrentCultureDownloads.Append(Cultures);
 		SuccessfulDownloads = 0;
+		ChangedCultureDownloads.Empty();
+		ChangedPoFiles.Empty();
 
 		const float AmountOfWork = CurrentCultureDownloads.Num();
 		ImportAllCulturesForTargetFromGridlySlowTask = MakeShareable(new FScopedSlowTask(AmountOfWork,
@@ -338,6 +422,13 @@ void FGridlyLocalizationServiceProvider::OnImportCultureForTargetFromGridly(cons
 	if (Result == ELocalizationServiceOperationCommandResult::Succeeded)
 	{
 		SuccessfulDownloads++;
+
+		if (!IsDownloadUnchanged(DownloadLocalizationTargetOp.ToSharedRef()))
+		{
+			ChangedCultureDownloads.Add(DownloadLocalizationTargetOp->GetInLocale());
+			ChangedPoFiles.Add(FPaths::ConvertRelativePathToFull(
+				FPaths::ProjectDir() / DownloadLocalizationTargetOp->GetInRelativeOutputFilePathAndName()));
+		}
 	}
 	else
 	{
@@ -359,28 +450,42 @@ void FGridlyLocalizationServiceProvider::OnImportCultureForTargetFromGridly(cons
 		IMainFrameModule& MainFrameModule = FModuleManager::LoadModuleChecked<IMainFrameModule>(TEXT("MainFrame"));
 		const TSharedPtr<SWindow>& MainFrameParentWindow = MainFrameModule.GetParentWindow();
 
-		if (!bIsTargetSet)
+		if (!bIsTargetSet && ChangedCultureDownloads.Num() == 0)
+		{
+			UE_LOG(LogGridlyEditor, Log, TEXT("No culture of %s changed since the last import, skipping the import"), *TargetName);
+			DownloadedPolyglotTextDatas.Empty();
+			DownloadedTextSegments.Reset();
+		}
+		else if (!bIsTargetSet && ImportDownloadedCulturesInProcess(Target, ChangedCultureDownloads))
+		{
+			Target->UpdateWordCountsFromCSV();
+			Target->UpdateStatusFromConflictReport();
+			CommitImportedPoFileHashes();
+		}
+		else if (!bIsTargetSet)
 		{
 
 			//here we call the gather
-			LocalizationCommandletTasks::ImportTextForTarget(MainFrameParentWindow.ToSharedRef(), Target,
+			const bool bImported = LocalizationCommandletTasks::ImportTextForTarget(MainFrameParentWindow.ToSharedRef(), Target,
 				FPaths::GetPath(FPaths::GetPath(AbsoluteFilePathAndName)));
 
 			Target->UpdateWordCountsFromCSV();
 			Target->UpdateStatusFromConflictReport();
 
-
-
+			if (bImported)
+			{
+				CommitImportedPoFileHashes();
+			}
 		}
 	}
 }
 
-TSharedRef<IHttpRequest, ESPMode::ThreadSafe> CreateExportRequest(const TArray<FPolyglotTextData>& PolyglotTextDatas,
-	const TSharedPtr<FLocTextHelper>& LocTextHelperPtr, bool bIncludeTargetTranslations)
+TSharedRef<IHttpRequest, ESPMode::ThreadSafe> CreateExportRequest(TArrayView<const FGridlyExportText> ExportTexts,
+	const FGridlyExportSchema& ExportSchema)
 {
 	FString JsonString;
-	FGridlyExporter::ConvertToJson(PolyglotTextDatas, bIncludeTargetTranslations, LocTextHelperPtr, JsonString);
-	UE_LOG(LogGridlyEditor, Log, TEXT("Creating export request with %d entries"), PolyglotTextDatas.Num());
+	FGridlyExporter::ConvertToJson(ExportTexts, ExportSchema, JsonString);
+	UE_LOG(LogGridlyEditor, Log, TEXT("Creating export request with %d entries"), ExportTexts.Num());
 
 	const UGridlyGameSettings* GameSettings = GetMutableDefault<UGridlyGameSettings>();
 	const FString ApiKey = GameSettings->ExportApiKey;
@@ -388,15 +493,12 @@ TSharedRef<IHttpRequest, ESPMode::ThreadSafe> CreateExportRequest(const TArray<F
 
 	FStringFormatNamedArguments Args;
 	Args.Add(TEXT("ViewId"), *ViewId);
-	const FString Url = FString::Format(TEXT("https://api.gridly.com/v1/views/{ViewId}/records"), Args);
+	const FString Url = FGridlyHttp::GetApiUrl(FString::Format(TEXT("/v1/views/{ViewId}/records"), Args));
 
-	auto HttpRequest = FHttpModule::Get().CreateRequest();
+	auto HttpRequest = FGridlyHttp::CreateRequest(TEXT("POST"), Url, ApiKey);
 	HttpRequest->SetHeader(TEXT("Accept"), TEXT("application/json"));
 	HttpRequest->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
-	HttpRequest->SetHeader(TEXT("Authorization"), FString::Printf(TEXT("ApiKey %s"), *ApiKey));
-	HttpRequest->SetContentAsString(JsonString);
-	HttpRequest->SetVerb(TEXT("POST"));
-	HttpRequest->SetURL(Url);
+	FGridlyHttp::SetContentAsString(HttpRequest, JsonString);
 
 	return HttpRequest;
 }
@@ -436,7 +538,7 @@ void FGridlyLocalizationServiceProvider::OnExportNativeCultureForTargetToGridly(
 		if (HttpResponsePtr->GetResponseCode() == EHttpResponseCodes::Ok || HttpResponsePtr->GetResponseCode() == EHttpResponseCodes::Created)
 		{
 			// Success: process the response and log the result
-			const FString Content = HttpResponsePtr->GetContentAsString();
+			const FString Content = FGridlyHttp::GetContentAsString(HttpResponsePtr);
 			const auto JsonStringReader = TJsonReaderFactory<TCHAR>::Create(Content);
 			TArray<TSharedPtr<FJsonValue>> JsonValueArray;
 			FJsonSerializer::Deserialize(JsonStringReader, JsonValueArray);
@@ -444,13 +546,8 @@ void FGridlyLocalizationServiceProvider::OnExportNativeCultureForTargetToGridly(
 
 			// Continue processing or log success...
 
-			// Check if more requests are pending
-			TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> NextRequest;
-			if (ExportFromTargetRequestQueue.Dequeue(NextRequest))
-			{
-				NextRequest->ProcessRequest();
-			}
-			else
+			// Finish once every chunk is accepted, the upload window keeps sending the rest meanwhile
+			if (IsExportComplete())
 			{
 				// Call FetchGridlyCSV here after all export operations are done
 				if (bSyncRecords) {
@@ -474,7 +571,7 @@ void FGridlyLocalizationServiceProvider::OnExportNativeCultureForTargetToGridly(
 		else
 		{
 			// Handle HTTP error
-			const FString Content = HttpResponsePtr->GetContentAsString();
+			const FString Content = FGridlyHttp::GetContentAsString(HttpResponsePtr);
 			const FString ErrorReason = FString::Printf(TEXT("Error: %d, reason: %s"), HttpResponsePtr->GetResponseCode(), *Content);
 			UE_LOG(LogGridlyEditor, Error, TEXT("%s"), *ErrorReason);
 
@@ -536,7 +633,7 @@ void FGridlyLocalizationServiceProvider::OnExportTranslationsForTargetToGridly(F
 		if (HttpResponsePtr->GetResponseCode() == EHttpResponseCodes::Ok || HttpResponsePtr->GetResponseCode() == EHttpResponseCodes::Created)
 		{
 			// Success: process the response
-			const FString Content = HttpResponsePtr->GetContentAsString();
+			const FString Content = FGridlyHttp::GetContentAsString(HttpResponsePtr);
 			const auto JsonStringReader = TJsonReaderFactory<TCHAR>::Create(Content);
 			TArray<TSharedPtr<FJsonValue>> JsonValueArray;
 			FJsonSerializer::Deserialize(JsonStringReader, JsonValueArray);
@@ -544,13 +641,8 @@ void FGridlyLocalizationServiceProvider::OnExportTranslationsForTargetToGridly(F
 
 			// Continue processing or log success...
 
-			// Check if more requests are pending
-			TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> NextRequest;
-			if (ExportFromTargetRequestQueue.Dequeue(NextRequest))
-			{
-				NextRequest->ProcessRequest();
-			}
-			else
+			// Finish once every chunk is accepted, the upload window keeps sending the rest meanwhile
+			if (IsExportComplete())
 			{
 				// All export operations completed
 				const FString Message = FString::Printf(TEXT("Number of entries updated: %llu"), ExportForTargetEntriesUpdated);
@@ -571,7 +663,7 @@ void FGridlyLocalizationServiceProvider::OnExportTranslationsForTargetToGridly(F
 		else
 		{
 			// Handle HTTP error
-			const FString Content = HttpResponsePtr->GetContentAsString();
+			const FString Content = FGridlyHttp::GetContentAsString(HttpResponsePtr);
 			const FString ErrorReason = FString::Printf(TEXT("Error: %d, reason: %s"), HttpResponsePtr->GetResponseCode(), *Content);
 			UE_LOG(LogGridlyEditor, Error, TEXT("%s"), *ErrorReason);
 
@@ -600,39 +692,69 @@ void FGridlyLocalizationServiceProvider::OnExportTranslationsForTargetToGridly(F
 
 void FGridlyLocalizationServiceProvider::ExportForTargetToGridly(ULocalizationTarget* InLocalizationTarget, FHttpRequestCompleteDelegate& ReqDelegate, const FText& SlowTaskText, bool bIncTargetTranslation)
 {
-	TArray<FPolyglotTextData> PolyglotTextDatas;
-	TSharedPtr<FLocTextHelper> LocTextHelperPtr;
 	UERecords.Empty();
 	GridlyRecords.Empty();
+	ExportTexts.Reset();
+	ExportManifest.Reset();
 
+	// Chunks of an earlier export still queued or in flight are not uploaded anymore
 
-	if (FGridlyLocalizedText::GetAllTextAsPolyglotTextDatas(InLocalizationTarget, PolyglotTextDatas, LocTextHelperPtr))
+	if (ExportUploadWindow.IsValid())
 	{
-		size_t TotalRequests = 0;
+		ExportUploadWindow->Cancel();
+		ExportUploadWindow.Reset();
+	}
 
-		while (PolyglotTextDatas.Num() > 0)
+	if (FGridlyLocalizedText::GetAllTextForExport(InLocalizationTarget, ExportTexts))
+	{
+		UERecords.Reserve(ExportTexts.Num());
+		for (const FGridlyExportText& ExportText : ExportTexts)
 		{
-			const size_t ChunkSize = FMath::Min(GetMutableDefault<UGridlyGameSettings>()->ExportMaxRecordsPerRequest, PolyglotTextDatas.Num());
-			const TArray<FPolyglotTextData> ChunkPolyglotTextDatas(PolyglotTextDatas.GetData(), ChunkSize);
-			PolyglotTextDatas.RemoveAt(0, ChunkSize);
-			const auto HttpRequest = CreateExportRequest(ChunkPolyglotTextDatas, LocTextHelperPtr, bIncTargetTranslation);
-			HttpRequest->OnProcessRequestComplete() = ReqDelegate;
-			ExportFromTargetRequestQueue.Enqueue(HttpRequest);
-			for (int i = 0; i < ChunkPolyglotTextDatas.Num(); i++)
+			UERecords.Add(FGridlyTypeRecord(ExportText.PolyglotTextData.GetKey(), ExportText.PolyglotTextData.GetNamespace()));
+		}
+
+		const UGridlyGameSettings* GameSettings = GetDefault<UGridlyGameSettings>();
+		ExportSchema = MakeUnique<FGridlyExportSchema>(bIncTargetTranslation);
+
+		// Records gathered above are all kept in UERecords, so records deleted locally are still synced
+
+		if (GameSettings->bUseDeltaExport)
+		{
+			ExportManifest = MakeUnique<FGridlyExportManifest>(GameSettings->ExportViewId);
+			if (!GameSettings->bForceFullExport)
 			{
-				const FString& Key = ChunkPolyglotTextDatas[i].GetKey();  // Access the correct array
-				const FString& Namespace = ChunkPolyglotTextDatas[i].GetNamespace();  // Access the correct array
-				
-				UERecords.Add(FGridlyTypeRecord(Key, Namespace));
+				ExportManifest->Load();
 			}
 
-			TotalRequests++;
+			RemoveUnchangedExportTexts();
 		}
 
+		const int32 ChunkSize = FMath::Max(1, GameSettings->ExportMaxRecordsPerRequest);
+		const int32 TotalRequests = FMath::DivideAndRoundUp(ExportTexts.Num(), ChunkSize);
+
 		ExportForTargetEntriesUpdated = 0;
+		ExportRequestCompleteDelegate = ReqDelegate;
+
+		if (TotalRequests == 0 && ExportManifest.IsValid())
+		{
+			ExportManifest->Save();
+
+			const FString Message = TEXT("No entries changed since the last export");
+			UE_LOG(LogGridlyEditor, Log, TEXT("%s"), *Message);
 
-		TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> HttpRequest;
-		if (ExportFromTargetRequestQueue.Dequeue(HttpRequest))
+			if (!IsRunningCommandlet())
+			{
+				FMessageDialog::Open(EAppMsgType::Ok, FText::FromString(Message));
+			}
+
+			// Records deleted locally are still removed on Gridly
+
+			if (bIncTargetTranslation || GameSettings->bSyncRecords)
+			{
+				FetchGridlyCSV();
+			}
+		}
+		else if (TotalRequests > 0)
 		{
 			if (!IsRunningCommandlet())
 			{
@@ -641,14 +763,205 @@ void FGridlyLocalizationServiceProvider::ExportForTargetToGridly(ULocalizationTa
 			}
 
 			bExportRequestInProgress = true;
-			HttpRequest->ProcessRequest();
+
+			ExportUploadWindow = MakeShared<FGridlyUploadWindow>(TotalRequests, GameSettings->ExportMaxConcurrentRequests,
+				GameSettings->ExportMaxChunkRetries);
+			ExportUploadWindow->OnCreateRequest.BindRaw(this, &FGridlyLocalizationServiceProvider::CreateExportChunkRequest);
+			ExportUploadWindow->OnChunkComplete.BindRaw(this, &FGridlyLocalizationServiceProvider::OnExportChunkComplete);
+			ExportUploadWindow->Start();
+		}
+	}
+}
+
+void FGridlyLocalizationServiceProvider::RemoveUnchangedExportTexts()
+{
+	const bool bChangedCellsOnly = GetDefault<UGridlyGameSettings>()->bExportChangedCellsOnly;
+
+	TSet<FString> RecordIds;
+	RecordIds.Reserve(ExportTexts.Num());
+
+	FString RecordId;
+	int32 NumChanged = 0;
+	for (FGridlyExportText& ExportText : ExportTexts)
+	{
+		ExportSchema->GetRecordId(ExportText.PolyglotTextData, RecordId);
+		RecordIds.Add(RecordId);
+
+		TArray<FString> ChangedColumnIds;
+		ExportSchema->ForEachCell(ExportText, [this, &RecordId, &ChangedColumnIds](const FGridlyExportCell& Cell)
+		{
+			if (!ExportManifest->IsCellUnchanged(RecordId, Cell.ColumnId, FGridlyExportManifest::HashCell(Cell.Value, Cell.DataType)))
+			{
+				ChangedColumnIds.Add(Cell.ColumnId);
+			}
+		});
+
+		if (ChangedColumnIds.Num() == 0)
+		{
+			continue;
+		}
+
+		// Records Gridly has never accepted are always sent whole
+
+		if (bChangedCellsOnly && ExportManifest->HasRecord(RecordId))
+		{
+			ExportText.ExportColumnIds = MoveTemp(ChangedColumnIds);
+		}
+
+		if (&ExportTexts[NumChanged] != &ExportText)
+		{
+			ExportTexts[NumChanged] = MoveTemp(ExportText);
+		}
+
+		NumChanged++;
+	}
+
+	UE_LOG(LogGridlyEditor, Log, TEXT("Delta export: %d of %d entries changed since the last export"), NumChanged,
+		ExportTexts.Num());
+
+	ExportTexts.SetNum(NumChanged);
+	ExportManifest->RetainRecords(RecordIds);
+}
+
+void FGridlyLocalizationServiceProvider::RecordExportedCells(int32 StartIndex, int32 NumTexts)
+{
+	FString RecordId;
+	for (int32 Index = StartIndex; Index < StartIndex + NumTexts; Index++)
+	{
+		const FGridlyExportText& ExportText = ExportTexts[Index];
+		ExportSchema->GetRecordId(ExportText.PolyglotTextData, RecordId);
+
+		ExportSchema->ForEachCell(ExportText, [this, &RecordId, &ExportText](const FGridlyExportCell& Cell)
+		{
+			if (ExportText.ExportColumnIds.Num() == 0 || ExportText.ExportColumnIds.Contains(Cell.ColumnId))
+			{
+				ExportManifest->SetCell(RecordId, Cell.ColumnId, FGridlyExportManifest::HashCell(Cell.Value, Cell.DataType));
+			}
+		});
+	}
+}
+
+FHttpRequestPtr FGridlyLocalizationServiceProvider::CreateExportChunkRequest(int32 ChunkIndex)
+{
+	const int32 ChunkSize = FMath::Max(1, GetDefault<UGridlyGameSettings>()->ExportMaxRecordsPerRequest);
+	const int32 StartIndex = ChunkIndex * ChunkSize;
+	if (StartIndex >= ExportTexts.Num())
+	{
+		return nullptr;
+	}
+
+	const int32 NumTexts = FMath::Min(ChunkSize, ExportTexts.Num() - StartIndex);
+	return CreateExportRequest(MakeArrayView(ExportTexts).Slice(StartIndex, NumTexts), *ExportSchema);
+}
+
+void FGridlyLocalizationServiceProvider::OnExportChunkComplete(int32 ChunkIndex, FHttpRequestPtr HttpRequestPtr,
+	FHttpResponsePtr HttpResponsePtr, bool bSuccess)
+{
+	// Texts Gridly has accepted are not needed anymore. Chunks complete in any order, but each only once
+
+	const int32 ResponseCode = HttpResponsePtr.IsValid() ? HttpResponsePtr->GetResponseCode() : 0;
+	const bool bAccepted = bSuccess && (ResponseCode == EHttpResponseCodes::Ok || ResponseCode == EHttpResponseCodes::Created);
+	if (bAccepted)
+	{
+		const int32 ChunkSize = FMath::Max(1, GetDefault<UGridlyGameSettings>()->ExportMaxRecordsPerRequest);
+		const int32 StartIndex = ChunkIndex * ChunkSize;
+		const int32 NumTexts = FMath::Max(0, FMath::Min(ChunkSize, ExportTexts.Num() - StartIndex));
+
+		// Only cells Gridly has accepted are recorded, so a failed chunk is sent again by the next export
+
+		if (ExportManifest.IsValid())
+		{
+			RecordExportedCells(StartIndex, NumTexts);
+		}
+
+		for (int32 Index = StartIndex; Index < StartIndex + NumTexts; Index++)
+		{
+			ExportTexts[Index] = FGridlyExportText();
+		}
+
+		if (ExportForTargetToGridlySlowTask.IsValid())
+		{
+			ExportForTargetToGridlySlowTask->EnterProgressFrame(1.f);
 		}
 	}
+
+	ExportRequestCompleteDelegate.ExecuteIfBound(HttpRequestPtr, HttpResponsePtr, bSuccess && HttpResponsePtr.IsValid());
+
+	// Finished or failed, chunks still in flight are dropped
+
+	if (!bExportRequestInProgress)
+	{
+		if (ExportUploadWindow.IsValid())
+		{
+			ExportUploadWindow->Cancel();
+		}
+
+		if (ExportManifest.IsValid())
+		{
+			ExportManifest->Save();
+			ExportManifest.Reset();
+		}
+
+		ExportTexts.Empty();
+	}
+}
+
+bool FGridlyLocalizationServiceProvider::IsExportComplete() const
+{
+	return ExportUploadWindow.IsValid() && ExportUploadWindow->IsComplete();
 }
 
 bool FGridlyLocalizationServiceProvider::HasRequestsPending() const
 {
-	return !ExportFromTargetRequestQueue.IsEmpty() || bExportRequestInProgress;
+	return bExportRequestInProgress;
+}
+
+bool FGridlyLocalizationServiceProvider::ImportDownloadedCulturesInProcess(ULocalizationTarget* LocalizationTarget,
+	const TArray<FString>& Cultures)
+{
+	if (!GetMutableDefault<UGridlyGameSettings>()->bImportInProcess
+	    || (DownloadedPolyglotTextDatas.Num() == 0 && !DownloadedTextSegments.IsValid()))
+	{
+		return false;
+	}
+
+	const TArray<FPolyglotTextData> PolyglotTextDatas = MoveTemp(DownloadedPolyglotTextDatas);
+	DownloadedPolyglotTextDatas.Reset();
+
+	// Released once imported, which deletes the segment files
+	const TSharedPtr<FGridlyTextSegments, ESPMode::ThreadSafe> TextSegments = MoveTemp(DownloadedTextSegments);
+
+	const bool bImported = TextSegments
+		? FGridlyLocalizedText::ImportPolyglotTextDatas(LocalizationTarget, *TextSegments, Cultures)
+		: FGridlyLocalizedText::ImportPolyglotTextDatas(LocalizationTarget, PolyglotTextDatas, Cultures);
+
+	if (!bImported)
+	{
+		UE_LOG(LogGridlyEditor, Warning, TEXT("In-process import of %s failed, falling back to the import commandlet"),
+			*LocalizationTarget->Settings.Name);
+		return false;
+	}
+
+	return true;
+}
+
+void FGridlyLocalizationServiceProvider::CommitImportedPoFileHashes()
+{
+	// Only now are the files skipped when unchanged, so a culture whose import failed is imported again next time
+
+	for (const FString& PoFile : ChangedPoFiles)
+	{
+		FGridlyLocalizedTextConverter::CommitPoFileHash(PoFile);
+	}
+
+	ChangedPoFiles.Empty();
+}
+
+bool FGridlyLocalizationServiceProvider::IsDownloadUnchanged(
+	const TSharedRef<FDownloadLocalizationTargetFile, ESPMode::ThreadSafe>& Operation) const
+{
+	return UnchangedDownloads.Contains(
+		FPaths::ConvertRelativePathToFull(FPaths::ProjectDir() / Operation->GetInRelativeOutputFilePathAndName()));
 }
 
 FHttpRequestCompleteDelegate FGridlyLocalizationServiceProvider::CreateExportNativeCultureDelegate()
@@ -664,22 +977,56 @@ void FGridlyLocalizationServiceProvider::FetchGridlyCSV()
 	// URL for fetching the CSV from Gridly
 	FStringFormatNamedArguments Args;
 	Args.Add(TEXT("ViewId"), *ViewId);
-	const FString GridlyURL = FString::Format(TEXT("https://api.gridly.com/v1/views/{ViewId}/export"), Args);
+	FString GridlyURL = FGridlyHttp::GetApiUrl(FString::Format(TEXT("/v1/views/{ViewId}/export"), Args));
+
+	// Only the Record ID and Path columns are read, so the export is narrowed down to the source columns of the native
+	// cultures instead of every column of the view
 
-	// Create the HTTP request
-	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> HttpRequest = FHttpModule::Get().CreateRequest();
-	HttpRequest->SetVerb(TEXT("GET"));
-	HttpRequest->SetURL(GridlyURL);
+	if (GameSettings->bImportMappedColumnsOnly)
+	{
+		const TArray<FString> TargetCultures = FGridlyCultureConverter::GetTargetCultures();
+
+		TArray<FString> ColumnIds;
+		for (const ULocalizationTarget* LocalizationTarget : ULocalizationSettings::GetGameTargetSet()->TargetObjects)
+		{
+			if (!LocalizationTarget
+			    || !LocalizationTarget->Settings.SupportedCulturesStatistics.IsValidIndex(LocalizationTarget->Settings.NativeCultureIndex))
+			{
+				continue;
+			}
 
-	// Set the required headers, including the authorization
-	HttpRequest->SetHeader(TEXT("Authorization"), FString::Printf(TEXT("ApiKey %s"), *ApiKey));
+			const FString& NativeCulture =
+				LocalizationTarget->Settings.SupportedCulturesStatistics[LocalizationTarget->Settings.NativeCultureIndex].CultureName;
+
+			// A column named after another Gridly culture may resolve to this one, so every column is requested instead
+
+			FString GridlyCulture;
+			if (!FGridlyCultureConverter::ConvertToGridlyColumnCulture(TargetCultures, NativeCulture, GridlyCulture))
+			{
+				ColumnIds.Reset();
+				break;
+			}
+
+			ColumnIds.AddUnique(GameSettings->SourceLanguageColumnIdPrefix + GridlyCulture);
+		}
+
+		if (ColumnIds.Num() > 0)
+		{
+			GridlyURL += TEXT("?columnIds=") + FGenericPlatformHttp::UrlEncode(FString::Join(ColumnIds, TEXT(",")));
+		}
+	}
+
+	// Create the HTTP request, including the authorization
+	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> HttpRequest = FGridlyHttp::CreateRequest(TEXT("GET"), GridlyURL, ApiKey);
+
+	// Set the required headers
 	HttpRequest->SetHeader(TEXT("Accept"), TEXT("text/csv"));
 
 	// Bind a callback to handle the response
 	HttpRequest->OnProcessRequestComplete().BindRaw(this, &FGridlyLocalizationServiceProvider::OnGridlyCSVResponseReceived);
 
 	// Send the request
-	HttpRequest->ProcessRequest();
+	FGridlyRateLimiter::Get().ProcessRequest(HttpRequest);
 }
 
 void FGridlyLocalizationServiceProvider::OnGridlyCSVResponseReceived(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful)
@@ -690,186 +1037,150 @@ void FGridlyLocalizationServiceProvider::OnGridlyCSVResponseReceived(FHttpReques
 		return;
 	}
 
-	// Retrieve the response content (CSV data)
-	FString CSVContent = Response->GetContentAsString();
+	// Read the response content (CSV data) as the UTF-8 it arrived in, only the kept fields are converted
+	TArray<uint8> DecompressedContent;
+	FUtf8StringView CSVContent;
+	if (!FGridlyHttp::GetContentAsUtf8(Response, DecompressedContent, CSVContent))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to read Gridly CSV"));
+		return;
+	}
 
 	// Parse the CSV data to extract records
 	ParseCSVAndCreateRecords(CSVContent);
 }
 
-
-void FGridlyLocalizationServiceProvider::ParseCSVAndCreateRecords(const FString& CSVContent)
+namespace GridlyLocalizationServiceProvider
 {
-	const TCHAR QuoteChar = TEXT('"');
-	const TCHAR Delimiter = TEXT(',');
-
-	bool bInsideQuotes = false;
-	FString CurrentField;
-	TArray<FString> Fields;
-	FString CurrentLine;
-
-	// Buffer to store the accumulated lines in case of multi-line records
-	TArray<FString> AccumulatedLines;
-
-	int32 RecordIdColumnIndex = -1;
-	int32 PathColumnIndex = -1;
+	/** A field of a CSV line, pointing into the content. Quoted fields point between the quotes */
+	struct FCSVField
+	{
+		FUtf8StringView Value;
+		bool bQuoted = false;
+	};
 
-	// First pass: determine which columns contain the Record ID and Path
-	bool bFoundHeader = false;
-	for (int32 i = 0; i < CSVContent.Len(); ++i)
+	/** Splits the line starting at Pos into fields, and returns the position after it. Quoted fields can span lines */
+	int32 ReadCSVLine(FUtf8StringView Content, int32 Pos, TArray<FCSVField>& OutFields)
 	{
-		TCHAR Char = CSVContent[i];
+		const UTF8CHAR QuoteChar = UTF8CHAR('"');
+		const UTF8CHAR Delimiter = UTF8CHAR(',');
+
+		OutFields.Reset();
 
-		if (bInsideQuotes)
+		const int32 Len = Content.Len();
+		while (Pos < Len)
 		{
-			if (Char == QuoteChar)
+			FCSVField& Field = OutFields.AddDefaulted_GetRef();
+
+			const int32 Start = Pos;
+			if (Content[Pos] == QuoteChar)
 			{
-				if (i + 1 < CSVContent.Len() && CSVContent[i + 1] == QuoteChar)
+				// Doubled quotes are escaped quotes, kept as they are until the field is converted
+
+				Pos++;
+				while (Pos < Len && (Content[Pos] != QuoteChar || (Pos + 1 < Len && Content[Pos + 1] == QuoteChar)))
 				{
-					CurrentField += QuoteChar;
-					++i;
+					Pos += Content[Pos] == QuoteChar ? 2 : 1;
 				}
-				else
+
+				Field.Value = Content.Mid(Start + 1, Pos - Start - 1);
+				Field.bQuoted = true;
+
+				// Anything between the closing quote and the delimiter is dropped
+				while (Pos < Len && Content[Pos] != Delimiter && Content[Pos] != '\n' && Content[Pos] != '\r')
 				{
-					bInsideQuotes = false;
+					Pos++;
 				}
 			}
 			else
 			{
-				CurrentField += Char;
-			}
-		}
-		else
-		{
-			if (Char == QuoteChar)
-			{
-				bInsideQuotes = true;
-			}
-			else if (Char == Delimiter)
-			{
-				Fields.Add(CurrentField);
-				CurrentField.Empty();
-			}
-			else if (Char == '\n' || Char == '\r')
-			{
-				// End of header line, process the column headers
-				if (Fields.Num() > 0 || !CurrentField.IsEmpty())
+				while (Pos < Len && Content[Pos] != Delimiter && Content[Pos] != '\n' && Content[Pos] != '\r')
 				{
-					Fields.Add(CurrentField);
-					CurrentField.Empty();
+					Pos++;
 				}
 
-				if (!bFoundHeader)
-				{
-					for (int32 ColumnIndex = 0; ColumnIndex < Fields.Num(); ++ColumnIndex)
-					{
-						FString ColumnName = Fields[ColumnIndex].TrimQuotes();
-
-						if (ColumnName.Equals(TEXT("Record ID"), ESearchCase::IgnoreCase))
-						{
-							RecordIdColumnIndex = ColumnIndex;
-						}
-						else if (ColumnName.Equals(TEXT("Path"), ESearchCase::IgnoreCase))
-						{
-							PathColumnIndex = ColumnIndex;
-						}
-					}
-
-					bFoundHeader = true;
-					Fields.Empty();
-				}
+				Field.Value = Content.Mid(Start, Pos - Start);
 			}
-			else
+
+			if (Pos >= Len || Content[Pos] != Delimiter)
 			{
-				CurrentField += Char;
+				break;
 			}
+
+			Pos++;
 		}
-	}
 
-	// Check if we found both necessary columns
-	if (RecordIdColumnIndex == -1 || PathColumnIndex == -1)
-	{
-		UE_LOG(LogTemp, Error, TEXT("Failed to identify Record ID or Path columns in CSV."));
-		return;
+		// Empty lines, and the second half of CRLF, make no fields
+
+		if (OutFields.Num() == 1 && !OutFields[0].bQuoted && OutFields[0].Value.IsEmpty())
+		{
+			OutFields.Reset();
+		}
+
+		return Pos < Len ? Pos + 1 : Pos;
 	}
 
-	// Second pass: parse the actual records
-	bInsideQuotes = false;
-	Fields.Empty();
-	CurrentField.Empty();
-	for (int32 i = 0; i < CSVContent.Len(); ++i)
+	FString ConvertCSVField(const FCSVField& Field)
 	{
-		TCHAR Char = CSVContent[i];
-
-		if (bInsideQuotes)
+		FString Value(Field.Value.Len(), Field.Value.GetData());
+		if (Field.bQuoted)
 		{
-			if (Char == QuoteChar)
-			{
-				if (i + 1 < CSVContent.Len() && CSVContent[i + 1] == QuoteChar)
-				{
-					CurrentField += QuoteChar;
-					++i;
-				}
-				else
-				{
-					bInsideQuotes = false;
-				}
-			}
-			else
-			{
-				CurrentField += Char;
-			}
+			Value.ReplaceInline(TEXT("\"\""), TEXT("\""), ESearchCase::CaseSensitive);
 		}
-		else
-		{
-			if (Char == QuoteChar)
-			{
-				bInsideQuotes = true;
-			}
-			else if (Char == Delimiter)
-			{
-				Fields.Add(CurrentField);
-				CurrentField.Empty();
-			}
-			else if (Char == '\n' || Char == '\r')
-			{
-				if (Fields.Num() > 0 || !CurrentField.IsEmpty())
-				{
-					Fields.Add(CurrentField);
-					CurrentField.Empty();
-				}
 
-				if (Fields.Num() > FMath::Max(RecordIdColumnIndex, PathColumnIndex))
-				{
-					FString RecordId = Fields[RecordIdColumnIndex].TrimQuotes();
-					FString Path = Fields[PathColumnIndex].TrimQuotes();
+		return Value.TrimQuotes();
+	}
+}
 
+void FGridlyLocalizationServiceProvider::ParseCSVAndCreateRecords(FUtf8StringView CSVContent)
+{
+	using namespace GridlyLocalizationServiceProvider;
 
-					FGridlyTypeRecord NewRecord(RemoveNamespaceFromKey(RecordId), Path);
+	// A single pass over the content. Fields are views into it, and only the header and the Record ID and Path fields of each
+	// line are converted to strings
 
-					if (NewRecord.Id != "Record ID") {
-						GridlyRecords.Add(NewRecord);
-					}
-				}
+	TArray<FCSVField> Fields;
+	int32 Pos = 0;
 
-				Fields.Empty();
-			}
-			else
-			{
-				CurrentField += Char;
-			}
+	int32 RecordIdColumnIndex = -1;
+	int32 PathColumnIndex = -1;
+
+	// The first line holds the column headers, which tell which columns contain the Record ID and Path
+	while (Pos < CSVContent.Len() && Fields.Num() == 0)
+	{
+		Pos = ReadCSVLine(CSVContent, Pos, Fields);
+	}
+
+	for (int32 ColumnIndex = 0; ColumnIndex < Fields.Num(); ++ColumnIndex)
+	{
+		const FString ColumnName = ConvertCSVField(Fields[ColumnIndex]);
+
+		if (ColumnName.Equals(TEXT("Record ID"), ESearchCase::IgnoreCase))
+		{
+			RecordIdColumnIndex = ColumnIndex;
+		}
+		else if (ColumnName.Equals(TEXT("Path"), ESearchCase::IgnoreCase))
+		{
+			PathColumnIndex = ColumnIndex;
 		}
 	}
 
-	// Handle the last line if needed
-	if (Fields.Num() > 0 || !CurrentField.IsEmpty())
+	// Check if we found both necessary columns
+	if (RecordIdColumnIndex == -1 || PathColumnIndex == -1)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to identify Record ID or Path columns in CSV."));
+		return;
+	}
+
+	// Parse the actual records
+	while (Pos < CSVContent.Len())
 	{
-		Fields.Add(CurrentField);
+		Pos = ReadCSVLine(CSVContent, Pos, Fields);
+
 		if (Fields.Num() > FMath::Max(RecordIdColumnIndex, PathColumnIndex))
 		{
-			FString RecordId = Fields[RecordIdColumnIndex].TrimQuotes();
-			FString Path = Fields[PathColumnIndex].TrimQuotes();
-
+			const FString RecordId = ConvertCSVField(Fields[RecordIdColumnIndex]);
+			const FString Path = ConvertCSVField(Fields[PathColumnIndex]);
 
 			FGridlyTypeRecord NewRecord(RemoveNamespaceFromKey(RecordId), Path);
 
@@ -878,7 +1189,6 @@ void FGridlyLocalizationServiceProvider::ParseCSVAndCreateRecords(const FString&
 			}
 		}
 	}
-
 	for (const FGridlyTypeRecord& Record : UERecords)
 	{
 		UE_LOG(LogTemp, Log, TEXT("UE Record ID: %s, Path: %s"), *Record.Id, *Record.Path);
@@ -1003,19 +1313,16 @@ void FGridlyLocalizationServiceProvider::DeleteRecordsFromGridly(const TArray<FS
 
 		FStringFormatNamedArguments Args;
 		Args.Add(TEXT("ViewId"), *ViewId);
-		const FString Url = FString::Format(TEXT("https://api.gridly.com/v1/views/{ViewId}/records"), Args);
+		const FString Url = FGridlyHttp::GetApiUrl(FString::Format(TEXT("/v1/views/{ViewId}/records"), Args));
 
-		TSharedRef<IHttpRequest, ESPMode::ThreadSafe> HttpRequest = FHttpModule::Get().CreateRequest();
-		HttpRequest->SetVerb(TEXT("DELETE"));
+		TSharedRef<IHttpRequest, ESPMode::ThreadSafe> HttpRequest = FGridlyHttp::CreateRequest(TEXT("DELETE"), Url, ApiKey);
 		HttpRequest->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
-		HttpRequest->SetHeader(TEXT("Authorization"), FString::Printf(TEXT("ApiKey %s"), *ApiKey));
-		HttpRequest->SetURL(Url);
-		HttpRequest->SetContentAsString(JsonPayload);
+		FGridlyHttp::SetContentAsString(HttpRequest, JsonPayload);
 
 		// Bind the response handler for each batch
 		HttpRequest->OnProcessRequestComplete().BindRaw(this, &FGridlyLocalizationServiceProvider::OnDeleteRecordsResponse);
 
-		HttpRequest->ProcessRequest();
+		FGridlyRateLimiter::Get().ProcessRequest(HttpRequest);
 
 		// Track the number of records requested for deletion
 		ExportForTargetEntriesDeleted += BatchRecords.Num();
@@ -1054,7 +1361,7 @@ void FGridlyLocalizationServiceProvider::OnDeleteRecordsResponse(FHttpRequestPtr
 	{
 		// Handle any failure cases
 		FString ErrorMessage = FString::Printf(TEXT("Failed to delete records. HTTP Code: %d, Response: %s"),
-			Response->GetResponseCode(), *Response->GetContentAsString());
+			Response->GetResponseCode(), *FGridlyHttp::GetContentAsString(Response));
 
 		UE_LOG(LogGridlyLocalizationServiceProvider, Error, TEXT("%s"), *ErrorMessage);
 
@@ -1062,7 +1369,7 @@ void FGridlyLocalizationServiceProvider::OnDeleteRecordsResponse(FHttpRequestPtr
 		if (CompletedBatches == TotalBatchesToProcess && !IsRunningCommandlet())
 		{
 			FString DialogMessage = FString::Printf(TEXT("Error during record deletion.\nHTTP Code: %d\nResponse: %s"),
-				Response->GetResponseCode(), *Response->GetContentAsString());
+				Response->GetResponseCode(), *FGridlyHttp::GetContentAsString(Response));
 
 			FMessageDialog::Open(EAppMsgType::Ok, FText::FromString(DialogMessage));
 		}
@@ -1071,7 +1378,7 @@ void FGridlyLocalizationServiceProvider::OnDeleteRecordsResponse(FHttpRequestPtr
 
 
 
-FString FGridlyLocalizationServiceProvider::RemoveNamespaceFromKey(FString& InputString)
+FString FGridlyLocalizationServiceProvider::RemoveNamespaceFromKey(const FString& InputString)
 {
 
 	// Find the first comma and chop the string from the right if a comma exists
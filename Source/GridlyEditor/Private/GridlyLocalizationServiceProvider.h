@@ -4,10 +4,18 @@
 
 #include "CoreMinimal.h"
 
+#include "GridlyExporter.h"
+#include "GridlyExportManifest.h"
+#include "GridlyLocalizedText.h"
+#include "GridlyResult.h"
+#include "GridlyTextSegments.h"
+#include "GridlyUploadWindow.h"
 #include "ILocalizationServiceOperation.h"
 #include "ILocalizationServiceProvider.h"
 #include "ILocalizationServiceState.h"
 #include "Interfaces/IHttpRequest.h"
+#include "Internationalization/PolyglotTextData.h"
+#include "LocalizationServiceOperations.h"
 #include <string>
 #include <fstream>
 #include <iostream>
@@ -71,15 +79,39 @@ public:
 	FHttpRequestCompleteDelegate CreateExportNativeCultureDelegate();
 	bool HasRequestsPending() const;
 
+	/** True if the file of a completed download was left untouched, because its contents did not change since the last import */
+	bool IsDownloadUnchanged(const TSharedRef<FDownloadLocalizationTargetFile, ESPMode::ThreadSafe>& Operation) const;
+
+	/** Imports the cultures of the last download into a target in this process. Returns false if the import commandlets should be used instead */
+	bool ImportDownloadedCulturesInProcess(ULocalizationTarget* LocalizationTarget, const TArray<FString>& Cultures);
+
 	void ExportForTargetToGridly(ULocalizationTarget* LocalizationTarget, FHttpRequestCompleteDelegate& ReqDelegate, const FText& SlowTaskText, bool bIncTargetTranslation = false);
 
 	// New functions for fetching and parsing CSV from Gridly
 	void FetchGridlyCSV(); // Fetches the CSV data from Gridly
 	void OnGridlyCSVResponseReceived(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful); // Callback for when the CSV is received
-	void ParseCSVAndCreateRecords(const FString& CSVContent); // Parses CSV content and creates records
+	void ParseCSVAndCreateRecords(FUtf8StringView CSVContent); // Parses UTF-8 CSV content and creates records
 
 private:
 	// Import
+
+	struct FGridlyPendingDownload
+	{
+		TSharedRef<FDownloadLocalizationTargetFile, ESPMode::ThreadSafe> Operation;
+		FLocalizationServiceOperationComplete OnComplete;
+	};
+
+	/** A single download of the import views, shared by every culture requested while it is in progress */
+	struct FGridlyImportSession
+	{
+		TArray<FGridlyPendingDownload> PendingOperations;
+	};
+
+	TSharedPtr<FGridlyImportSession> ImportSession;
+	void OnImportSessionDownloaded(const TArray<FPolyglotTextData>& PolyglotTextDatas,
+		const TSharedPtr<FGridlyTextSegments, ESPMode::ThreadSafe>& TextSegments);
+	void OnImportSessionFailed(const TArray<FPolyglotTextData>& PolyglotTextDatas, const FGridlyResult& Error);
+
 	bool IsFileNotEmpty(const std::string& filePath);
 	void ImportAllCulturesForTargetFromGridly(TWeakObjectPtr<ULocalizationTarget> LocalizationTarget, bool bIsTargetSet);
 	void OnImportCultureForTargetFromGridly(const FLocalizationServiceOperationRef& Operation,
@@ -87,6 +119,12 @@ private:
 	TSharedPtr<FScopedSlowTask> ImportAllCulturesForTargetFromGridlySlowTask;
 	TArray<FString> CurrentCultureDownloads;
 	int SuccessfulDownloads;
+	TArray<FString> ChangedCultureDownloads;
+	TArray<FString> ChangedPoFiles;
+	void CommitImportedPoFileHashes();
+	TSet<FString> UnchangedDownloads;
+	TArray<FPolyglotTextData> DownloadedPolyglotTextDatas;
+	TSharedPtr<FGridlyTextSegments, ESPMode::ThreadSafe> DownloadedTextSegments;
 	size_t ExportForTargetEntriesDeleted = 0;
 
 
@@ -94,9 +132,27 @@ private:
 
 	size_t ExportForTargetEntriesUpdated;
 	TSharedPtr<FScopedSlowTask> ExportForTargetToGridlySlowTask;
-	TQueue<TSharedPtr<IHttpRequest, ESPMode::ThreadSafe>> ExportFromTargetRequestQueue;
 	bool bExportRequestInProgress = false;
 
+	/**
+	 * Texts of the export in progress. Each chunk is an index range over them, only serialized once the upload window has a
+	 * free slot for it, and its texts are released as soon as Gridly has accepted them
+	 */
+	TArray<FGridlyExportText> ExportTexts;
+	TUniquePtr<FGridlyExportSchema> ExportSchema;
+	FHttpRequestCompleteDelegate ExportRequestCompleteDelegate;
+	TSharedPtr<FGridlyUploadWindow> ExportUploadWindow;
+
+	/** Cell hashes of the last export to the view, updated as chunks are accepted and saved once the export ends */
+	TUniquePtr<FGridlyExportManifest> ExportManifest;
+
+	void RemoveUnchangedExportTexts();
+	void RecordExportedCells(int32 StartIndex, int32 NumTexts);
+	FHttpRequestPtr CreateExportChunkRequest(int32 ChunkIndex);
+	void OnExportChunkComplete(int32 ChunkIndex, FHttpRequestPtr HttpRequestPtr, FHttpResponsePtr HttpResponsePtr,
+		bool bSuccess);
+	bool IsExportComplete() const;
+
 	void ExportNativeCultureForTargetToGridly(TWeakObjectPtr<ULocalizationTarget> LocalizationTarget, bool bIsTargetSet);
 	void OnExportNativeCultureForTargetToGridly(FHttpRequestPtr HttpRequestPtr, FHttpResponsePtr HttpResponsePtr, bool bSuccess);
 
@@ -107,7 +163,7 @@ private:
 
 	TArray<FGridlyTypeRecord> GridlyRecords; // List to store the records from Gridly
 	TArray<FGridlyTypeRecord> UERecords;
-	FString RemoveNamespaceFromKey(FString& InputString);
+	FString RemoveNamespaceFromKey(const FString& InputString);
 	
 	void DeleteRecordsFromGridly(const TArray<FString>& RecordsToDelete);
 	void OnDeleteRecordsResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful);
@@ -5,20 +5,17 @@
 
 #include "GridlyCultureConverter.h"
 #include "GridlyEditor.h"
+#include "GridlyTextSegments.h"
 #include "LocalizationConfigurationScript.h"
 #include "LocTextHelper.h"
 #include "Internationalization/PolyglotTextData.h"
 
-bool FGridlyLocalizedText::GetAllTextAsPolyglotTextDatas(ULocalizationTarget* LocalizationTarget,
-	TArray<FPolyglotTextData>& OutPolyglotTextDatas, TSharedPtr<FLocTextHelper>& LocTextHelper)
+static bool LoadLocTextHelper(ULocalizationTarget* LocalizationTarget, const TArray<FString>& Cultures,
+	TSharedPtr<FLocTextHelper>& OutLocTextHelper)
 {
 	const FString ConfigFilePath = LocalizationConfigurationScript::GetGatherTextConfigPath(LocalizationTarget);
 	const FString SectionName = TEXT("CommonSettings");
 
-	// Get native culture.
-	const int NativeCultureIndex = LocalizationTarget->Settings.NativeCultureIndex;
-	FString NativeCulture = LocalizationTarget->Settings.SupportedCulturesStatistics[NativeCultureIndex].CultureName;
-
 	// Get source path.
 	FString SourcePath;
 	if (!GConfig->GetString(*SectionName, TEXT("SourcePath"), SourcePath, ConfigFilePath))
@@ -67,35 +64,54 @@ bool FGridlyLocalizedText::GetAllTextAsPolyglotTextDatas(ULocalizationTarget* Lo
 		DestinationPath = FPaths::Combine(*FPaths::ProjectDir(), *DestinationPath);
 	}
 
-	const TArray<FString> CulturesToGenerate = FGridlyCultureConverter::GetTargetCultures();
+	// Get native culture.
+	const int NativeCultureIndex = LocalizationTarget->Settings.NativeCultureIndex;
+	const FString NativeCulture = LocalizationTarget->Settings.SupportedCulturesStatistics[NativeCultureIndex].CultureName;
 
-	// Load the manifest and all archives
-	LocTextHelper = MakeShareable(new FLocTextHelper(SourcePath, ManifestName, ArchiveName, NativeCulture, CulturesToGenerate, nullptr));
-	//FLocTextHelper LocTextHelper(SourcePath, ManifestName, ArchiveName, NativeCulture, CulturesToGenerate, nullptr);
+	OutLocTextHelper = MakeShareable(new FLocTextHelper(SourcePath, ManifestName, ArchiveName, NativeCulture, Cultures, nullptr));
 	{
 		FText LoadError;
-		if (!LocTextHelper->LoadAll(ELocTextHelperLoadFlags::LoadOrCreate, &LoadError))
+		if (!OutLocTextHelper->LoadAll(ELocTextHelperLoadFlags::LoadOrCreate, &LoadError))
 		{
 			UE_LOG(LogGridlyEditor, Error, TEXT("%s"), *LoadError.ToString());
 			return false;
 		}
 	}
 
+	return true;
+}
+
+bool FGridlyLocalizedText::GetAllTextForExport(ULocalizationTarget* LocalizationTarget, TArray<FGridlyExportText>& OutExportTexts)
+{
+	const TArray<FString> CulturesToGenerate = FGridlyCultureConverter::GetTargetCultures();
+
+	// Load the manifest and all archives
+	TSharedPtr<FLocTextHelper> LocTextHelper;
+	if (!LoadLocTextHelper(LocalizationTarget, CulturesToGenerate, LocTextHelper))
+	{
+		return false;
+	}
+
+	const FString NativeCulture = LocTextHelper->GetNativeCulture();
+
+	// Texts are indexed by their namespace in the manifest and key, so each translation is attached with a single lookup.
+	// Archives use the manifest namespace, which is empty for blueprint texts exported under their blueprint's name
+
+	TMap<TPair<FString, FString>, int32> ExportTextIndices;
+
 	LocTextHelper->EnumerateSourceTexts(
-		[&LocTextHelper, &OutPolyglotTextDatas, &NativeCulture](TSharedRef<FManifestEntry> InManifestEntry)
+		[&OutExportTexts, &ExportTextIndices, &NativeCulture](TSharedRef<FManifestEntry> InManifestEntry)
 		{
+			const FString& ManifestNamespace = InManifestEntry->Namespace.GetString();
+
 			for (const FManifestContext& Context : InManifestEntry->Contexts)
 			{
-				FLocItem TranslationText;
-				LocTextHelper->GetRuntimeText(NativeCulture, InManifestEntry->Namespace, Context.Key,
-					Context.KeyMetadataObj, ELocTextExportSourceMethod::NativeText, InManifestEntry->Source, TranslationText, true);
-
 				const FString SourceKey = Context.Key.GetString();
-				FString SourceNamespace = InManifestEntry->Namespace.GetString();
+				FString SourceNamespace = ManifestNamespace;
 				if (SourceNamespace.IsEmpty())
 				{
 					// Extract substring from Context.SourceLocation
-					FString SourceLocation = Context.SourceLocation;
+					const FString& SourceLocation = Context.SourceLocation;
 					int32 LastSlashPos;
 					if (SourceLocation.FindLastChar('/', LastSlashPos))
 					{
@@ -105,41 +121,33 @@ bool FGridlyLocalizedText::GetAllTextAsPolyglotTextDatas(ULocalizationTarget* Lo
 							SourceNamespace = "blueprints/" + SourceLocation.Mid(LastSlashPos + 1, FirstDotPos - LastSlashPos - 1);
 						}
 					}
-					else
-					{
-						// Handle case where extraction fails
-						SourceNamespace = ""; // Or any appropriate fallback
-					}
 				}
-				//1047
-				//const FString SourceText = TranslationText.Text;
-				const FString SourceText = InManifestEntry->Source.Text;
 
-				FPolyglotTextData PolyglotTextData(ELocalizedTextSourceCategory::Game, SourceNamespace, SourceKey, SourceText,
-					NativeCulture);
-				OutPolyglotTextDatas.Add(PolyglotTextData);
+				const FString& SourceText = InManifestEntry->Source.Text;
+
+				ExportTextIndices.Add(TPair<FString, FString>(ManifestNamespace, SourceKey), OutExportTexts.Num());
+
+				FGridlyExportText& ExportText = OutExportTexts.Emplace_GetRef(
+					FPolyglotTextData(ELocalizedTextSourceCategory::Game, SourceNamespace, SourceKey, SourceText, NativeCulture));
+				ExportText.SourceLocation = Context.SourceLocation;
+				ExportText.InfoMetadata = Context.InfoMetadataObj;
 			}
 			return true;
 		}, true);
 
-
-
-	for (int i = 0; i < CulturesToGenerate.Num(); i++)
+	for (const FString& CultureName : CulturesToGenerate)
 	{
-		const FString CultureName = CulturesToGenerate[i];
 		if (CultureName != NativeCulture)
 		{
 			LocTextHelper->EnumerateTranslations(CultureName,
-				[&CultureName, &OutPolyglotTextDatas](TSharedRef<FArchiveEntry> InManifestEntry)
+				[&CultureName, &OutExportTexts, &ExportTextIndices](TSharedRef<FArchiveEntry> InArchiveEntry)
 				{
-					FPolyglotTextData* PolyglotTextData = OutPolyglotTextDatas.FindByPredicate(
-						[&InManifestEntry](const FPolyglotTextData& PolyglotTextData)
-						{
-							return PolyglotTextData.GetKey() == InManifestEntry->Key.GetString();
-						});
-					if (PolyglotTextData)
+					const int32* ExportTextIndex = ExportTextIndices.Find(
+						TPair<FString, FString>(InArchiveEntry->Namespace.GetString(), InArchiveEntry->Key.GetString()));
+					if (ExportTextIndex)
 					{
-						PolyglotTextData->AddLocalizedString(CultureName, InManifestEntry->Translation.Text);
+						OutExportTexts[*ExportTextIndex].PolyglotTextData.AddLocalizedString(CultureName,
+							InArchiveEntry->Translation.Text);
 					}
 					return true;
 				}, true);
@@ -148,3 +156,157 @@ bool FGridlyLocalizedText::GetAllTextAsPolyglotTextDatas(ULocalizationTarget* Lo
 
 	return true;
 }
+
+/** Visits every downloaded text once, returning false if they could not all be read */
+using FGridlyForEachText = TFunctionRef<bool(TFunctionRef<void(const FPolyglotTextData&)>)>;
+
+static bool ImportTexts(ULocalizationTarget* LocalizationTarget, FGridlyForEachText ForEachText, const TArray<FString>& Cultures)
+{
+	// Every culture is loaded so the word count report stays complete, but only the given cultures are imported
+
+	TArray<FString> SupportedCultures;
+	for (const FCultureStatistics& CultureStats : LocalizationTarget->Settings.SupportedCulturesStatistics)
+	{
+		SupportedCultures.Add(CultureStats.CultureName);
+	}
+
+	TSharedPtr<FLocTextHelper> LocTextHelper;
+	if (!LoadLocTextHelper(LocalizationTarget, SupportedCultures, LocTextHelper))
+	{
+		return false;
+	}
+
+	const FString NativeCulture = LocTextHelper->GetNativeCulture();
+
+	TArray<FString> ImportCultures;
+	for (const FString& Culture : Cultures)
+	{
+		if (LocTextHelper->HasArchive(Culture))
+		{
+			ImportCultures.Add(Culture);
+		}
+		else
+		{
+			UE_LOG(LogGridlyEditor, Warning, TEXT("No archive for culture %s, skipping import"), *Culture);
+		}
+	}
+
+	// The texts are visited once for all cultures, so they can be streamed from disk
+
+	TArray<int32> NumImported;
+	NumImported.SetNumZeroed(ImportCultures.Num());
+	FString Translation;
+
+	const bool bReadTexts = ForEachText([&](const FPolyglotTextData& PolyglotTextData)
+	{
+		// Texts with an empty namespace are exported under their blueprint's name, see GetAllTextForExport
+
+		FString Namespace = PolyglotTextData.GetNamespace();
+		const FString& Key = PolyglotTextData.GetKey();
+		TSharedPtr<FManifestEntry> ManifestEntry = LocTextHelper->FindSourceText(Namespace, Key);
+		if (!ManifestEntry.IsValid() && Namespace.StartsWith(TEXT("blueprints/")))
+		{
+			Namespace.Reset();
+			ManifestEntry = LocTextHelper->FindSourceText(Namespace, Key);
+		}
+
+		const FManifestContext* Context = ManifestEntry.IsValid() ? ManifestEntry->FindContextByKey(Key) : nullptr;
+		if (!Context)
+		{
+			return;
+		}
+
+		for (int32 i = 0; i < ImportCultures.Num(); i++)
+		{
+			const FString& Culture = ImportCultures[i];
+			if (!PolyglotTextData.GetLocalizedString(Culture, Translation) || Translation.IsEmpty())
+			{
+				continue;
+			}
+
+			// Like the .po import, foreign translations are keyed on the native translation rather than the manifest source
+
+			FLocItem Source = ManifestEntry->Source;
+			if (Culture != NativeCulture)
+			{
+				const TSharedPtr<FArchiveEntry> NativeEntry = LocTextHelper->FindTranslation(NativeCulture, Namespace, Key,
+					Context->KeyMetadataObj);
+				if (NativeEntry.IsValid())
+				{
+					Source = NativeEntry->Translation;
+				}
+			}
+
+			const TSharedPtr<FArchiveEntry> ArchiveEntry = LocTextHelper->FindTranslation(Culture, Namespace, Key,
+				Context->KeyMetadataObj);
+			if (ArchiveEntry.IsValid() && ArchiveEntry->Source.Text.Equals(Source.Text, ESearchCase::CaseSensitive)
+			    && ArchiveEntry->Translation.Text.Equals(Translation, ESearchCase::CaseSensitive))
+			{
+				continue;
+			}
+
+			if (LocTextHelper->ImportTranslation(Culture, Namespace, Key, Context->KeyMetadataObj, Source, FLocItem(Translation),
+				Context->bIsOptional))
+			{
+				NumImported[i]++;
+			}
+		}
+	});
+
+	if (!bReadTexts)
+	{
+		UE_LOG(LogGridlyEditor, Error, TEXT("Unable to read the downloaded texts"));
+		return false;
+	}
+
+	for (int32 i = 0; i < ImportCultures.Num(); i++)
+	{
+		const FString& Culture = ImportCultures[i];
+		if (NumImported[i] == 0)
+		{
+			UE_LOG(LogGridlyEditor, Log, TEXT("No translation of %s changed, archive left untouched"), *Culture);
+			continue;
+		}
+
+		FText SaveError;
+		if (!LocTextHelper->SaveArchive(Culture, &SaveError))
+		{
+			UE_LOG(LogGridlyEditor, Error, TEXT("%s"), *SaveError.ToString());
+			return false;
+		}
+
+		UE_LOG(LogGridlyEditor, Log, TEXT("Imported %d translations of %s"), NumImported[i], *Culture);
+	}
+
+	FText ReportError;
+	if (!LocTextHelper->SaveWordCountReport(FDateTime::Now(),
+		LocalizationConfigurationScript::GetWordCountCSVPath(LocalizationTarget), &ReportError))
+	{
+		UE_LOG(LogGridlyEditor, Error, TEXT("%s"), *ReportError.ToString());
+		return false;
+	}
+
+	return true;
+}
+
+bool FGridlyLocalizedText::ImportPolyglotTextDatas(ULocalizationTarget* LocalizationTarget,
+	const TArray<FPolyglotTextData>& PolyglotTextDatas, const TArray<FString>& Cultures)
+{
+	return ImportTexts(LocalizationTarget, [&PolyglotTextDatas](TFunctionRef<void(const FPolyglotTextData&)> Visitor)
+	{
+		for (const FPolyglotTextData& PolyglotTextData : PolyglotTextDatas)
+		{
+			Visitor(PolyglotTextData);
+		}
+		return true;
+	}, Cultures);
+}
+
+bool FGridlyLocalizedText::ImportPolyglotTextDatas(ULocalizationTarget* LocalizationTarget, const FGridlyTextSegments& TextSegments,
+	const TArray<FString>& Cultures)
+{
+	return ImportTexts(LocalizationTarget, [&TextSegments](TFunctionRef<void(const FPolyglotTextData&)> Visitor)
+	{
+		return TextSegments.ForEachSorted(Visitor);
+	}, Cultures);
+}
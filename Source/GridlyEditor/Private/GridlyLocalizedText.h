@@ -4,12 +4,50 @@
 
 #include "CoreMinimal.h"
 
+#include "Internationalization/PolyglotTextData.h"
 #include "LocalizationTargetTypes.h"
 
-class FLocTextHelper;
+class FGridlyTextSegments;
+class FLocMetadataObject;
+
+/** A text of a localization target, gathered with everything exporting it needs, so the manifest is not searched again */
+struct FGridlyExportText
+{
+	FGridlyExportText() = default;
+	explicit FGridlyExportText(FPolyglotTextData&& InPolyglotTextData) :
+		PolyglotTextData(MoveTemp(InPolyglotTextData))
+	{
+	}
+
+	/** Namespace as exported, key, source text, and the translations of every target culture */
+	FPolyglotTextData PolyglotTextData;
+
+	/** Context of the text in the manifest */
+	FString SourceLocation;
+	TSharedPtr<FLocMetadataObject> InfoMetadata;
+
+	/** Columns to export when only the changed cells of the record are sent, every column when empty */
+	TArray<FString> ExportColumnIds;
+};
+
 class FGridlyLocalizedText
 {
 public:
-	static bool GetAllTextAsPolyglotTextDatas(ULocalizationTarget* LocalizationTarget,
-		TArray<FPolyglotTextData>& OutPolyglotTextDatas, TSharedPtr<FLocTextHelper>& LocTextHelper);
+	/**
+	 * Gathers every text of a target in manifest order. Texts are indexed by namespace and key once, so the translations of
+	 * all cultures are attached in a single pass over the archives
+	 */
+	static bool GetAllTextForExport(ULocalizationTarget* LocalizationTarget, TArray<FGridlyExportText>& OutExportTexts);
+
+	/**
+	 * Applies downloaded translations of the given cultures straight to the archives of a target, without going through
+	 * .po files and the import commandlet. Only archives with changed translations are saved, then the word count report
+	 * is regenerated
+	 */
+	static bool ImportPolyglotTextDatas(ULocalizationTarget* LocalizationTarget, const TArray<FPolyglotTextData>& PolyglotTextDatas,
+		const TArray<FString>& Cultures);
+
+	/** Same as above, streaming the texts from the segments of a memory-bounded download */
+	static bool ImportPolyglotTextDatas(ULocalizationTarget* LocalizationTarget, const FGridlyTextSegments& TextSegments,
+		const TArray<FString>& Cultures);
 };